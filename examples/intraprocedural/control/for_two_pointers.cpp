@@ -0,0 +1,18 @@
+#include <cstddef>
+
+void reverse(int n)
+{
+    int * arr = new int[n];
+    for (int i = 0, j = n - 1; i < j; ++i, --j)
+    {
+        int t = arr[i];
+        arr[i] = arr[j];
+        arr[j] = t;
+    }
+}
+
+int main()
+{
+    reverse(10);
+    return 0;
+}
@@ -0,0 +1,37 @@
+# Generates IR modules for comparing analysis profiles:
+# many.ll - 300 functions with guarded accesses calling each other,
+# big.ll  - a single function with 1500 guarded accesses.
+import random
+
+random.seed(1)
+N = 300
+L = []
+for i in range(N):
+    L.append(f'define void @f{i}(i32 %n, i32 %k) {{')
+    L.append('entry:')
+    L.append('  %buf = alloca i32, i32 %n')
+    L.append('  %c = icmp slt i32 %k, %n')
+    L.append('  br i1 %c, label %ok, label %out')
+    L.append('ok:')
+    L.append('  %p = getelementptr i32, i32* %buf, i32 %k')
+    L.append('  store i32 0, i32* %p')
+    L.append('  %q = getelementptr i32, i32* %buf, i32 %n')
+    L.append('  store i32 0, i32* %q')
+    for j in range(3):
+        t = random.randrange(N)
+        if t < i or random.random() < 0.05:
+            L.append(f'  call void @f{t}(i32 {random.randrange(20)}, i32 {random.randrange(20)})')
+    L.append('  br label %out')
+    L.append('out:')
+    L.append('  ret void')
+    L.append('}')
+open('many.ll', 'w').write('\n'.join(L) + '\n')
+
+N = 1500
+L = ['define void @big(i32 %x, i32 %y) {', 'entry:', '  %buf = alloca i32, i32 64', '  br label %b0']
+for i in range(N):
+    L += [f'b{i}:', f'  %c{i} = icmp slt i32 %x, {i + 100}', f'  br i1 %c{i}, label %t{i}, label %f{i}',
+          f't{i}:', f'  %p{i} = getelementptr i32, i32* %buf, i32 %y', f'  store i32 0, i32* %p{i}', f'  br label %b{i + 1}',
+          f'f{i}:', f'  br label %b{i + 1}']
+L += [f'b{N}:', '  ret void', '}']
+open('big.ll', 'w').write('\n'.join(L) + '\n')
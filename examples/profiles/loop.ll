@@ -0,0 +1,40 @@
+define void @f(i32 %n) {
+entry:
+  %buf = alloca i32, i32 10
+  br label %header
+header:
+  %i = phi i32 [ 0, %entry ], [ %inc, %body ]
+  %cmp = icmp slt i32 %i, 10
+  br i1 %cmp, label %body, label %exit
+body:
+  %p = getelementptr i32, i32* %buf, i32 %i
+  store i32 0, i32* %p
+  %inc = add i32 %i, 1
+  br label %header
+exit:
+  %q = getelementptr i32, i32* %buf, i32 %i
+  store i32 1, i32* %q
+  ret void
+}
+
+define void @g(i32 %n, i32 %k) {
+entry:
+  %buf = alloca i32, i32 %n
+  %c = icmp slt i32 %k, %n
+  br i1 %c, label %ok, label %bad
+ok:
+  %p = getelementptr i32, i32* %buf, i32 %k
+  store i32 0, i32* %p
+  br label %bad
+bad:
+  %r = getelementptr i32, i32* %buf, i32 %k
+  store i32 0, i32* %r
+  ret void
+}
+
+define void @h() {
+entry:
+  call void @g(i32 5, i32 7)
+  call void @g(i32 5, i32 2)
+  ret void
+}
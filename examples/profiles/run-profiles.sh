@@ -0,0 +1,13 @@
+#!/bin/bash
+# Prints wall time and totals of every analysis profile on every module.
+# Usage: run-profiles.sh [path to Sleuth]
+sleuth=$(realpath "${1:-Sleuth}")
+cd "$(dirname "$0")"
+python3 gen-modules.py
+TIMEFORMAT=%Rs
+for module in loop.ll many.ll big.ll; do
+    for profile in fast balanced thorough; do
+        echo "$module --profile $profile"
+        time "$sleuth" -n --profile $profile $module | tail -1
+    done
+done
@@ -17,6 +17,7 @@
 #include <llvm/Support/SourceMgr.h>
 
 namespace fs = boost::filesystem;
+using llvm::cast;
 using llvm::dyn_cast;
 using llvm::dyn_cast_or_null;
 
@@ -29,15 +30,15 @@ using boost::tribool;
 
 bool is_argument_only(var_id var)
 {
-    if (!!dynamic_cast<llvm::Argument const *>(var))
+    if (var && llvm::isa<llvm::Argument>(var))
     {
         return true;
     }
-    else if (auto sext = dynamic_cast<llvm::SExtInst const *>(var))
+    else if (auto sext = dyn_cast_or_null<llvm::SExtInst>(var))
     {
         return is_argument_only(sext->getOperand(0));
     }
-    else if (auto zext = dynamic_cast<llvm::ZExtInst const *>(var))
+    else if (auto zext = dyn_cast_or_null<llvm::ZExtInst>(var))
     {
         return is_argument_only(zext->getOperand(0));
     }
@@ -45,24 +46,26 @@ bool is_argument_only(var_id var)
     return false;
 }
 
-bool is_argument_only(sym_atomic_ptr const & atom)
+bool is_argument_only(sym_atomic_ptr ptr)
 {
-    auto ptr = atom.get();
-    if (dynamic_cast<atomic_const const *>(ptr))
+    switch (ptr->kind())
     {
+    case sym_atomic::Const:
         return true;
-    }
-    else if (auto var = dynamic_cast<atomic_var const *>(ptr))
+    case sym_atomic::Var:
+        return is_argument_only(llvm::cast<atomic_var>(ptr)->var());
+    case sym_atomic::Linear:
+        return is_argument_only(llvm::cast<atomic_linear>(ptr)->atom());
+    case sym_atomic::BinOp:
     {
-        return is_argument_only(var->var());
+        auto bin_op = llvm::cast<atomic_bin_op>(ptr);
+        return is_argument_only(bin_op->lhs()) && is_argument_only(bin_op->rhs());
     }
-    else if (auto linear = dynamic_cast<atomic_linear const *>(ptr))
+    case sym_atomic::Sum:
     {
-        return is_argument_only(linear->atom());
+        auto sum = llvm::cast<atomic_sum>(ptr);
+        return is_argument_only(sum->atom()) && (!sum->next() || is_argument_only(sum->next()));
     }
-    else if (auto bin_op = dynamic_cast<atomic_bin_op const *>(ptr))
-    {
-        return is_argument_only(bin_op->lhs()) && is_argument_only(bin_op->rhs());
     }
 
     return false;
@@ -82,8 +85,10 @@ struct check_overflow_res_t
 
 // Returns true if there definitely is an overflow, indeterminate if it can't
 // determine presense of overflow and false if there is definitely no overflow
+// Accesses bounded by arguments are left to triggers checked at call sites,
+// unless 'use_triggers' is false.
 check_overflow_res_t check_overflow(sym_range const & size_range, sym_range const & idx_range,
-                                    llvm::Instruction const & instr)
+                                    llvm::Instruction const & instr, bool use_triggers)
 {
     if (size_range.hi <= idx_range.hi || idx_range.lo <= sym_expr(scalar_t(-1)))
         return {true, {}};
@@ -91,12 +96,12 @@ check_overflow_res_t check_overflow(sym_range const & size_range, sym_range cons
     std::vector<trigger_t> triggers;
     bool a1 = is_argument_only(size_range.hi);
     bool a2 = is_argument_only(idx_range.hi);
-    if (is_argument_only(size_range.hi) && is_argument_only(idx_range.hi))
+    if (use_triggers && is_argument_only(size_range.hi) && is_argument_only(idx_range.hi))
     {
         triggers.push_back({size_range.hi, idx_range.hi, instr});
     }
 
-    if (is_argument_only(idx_range.lo))
+    if (use_triggers && is_argument_only(idx_range.lo))
     {
         triggers.push_back(trigger_t(idx_range.lo, sym_expr(scalar_t(-1)), instr));
     }
@@ -119,7 +124,7 @@ check_overflow_res_t check_overflow(sym_range const & size_range, sym_range cons
 // size is number of elements, not bytes
 sym_range analyzer_t::compute_buffer_size_range(llvm::Value const & v)
 {
-//    if (auto llvm_arg = dynamic_cast<llvm::Argument const *>(&v))
+//    if (auto llvm_arg = dyn_cast<llvm::Argument>(&v))
 //    {
 //        argument_t arg = {llvm_arg->getParent(), llvm_arg->getArgNo()};
 //        auto iter = pimpl().ctx.arg_size_ranges.find(arg);
@@ -127,20 +132,37 @@ sym_range analyzer_t::compute_buffer_size_range(llvm::Value const & v)
 //            return iter->second;
 //    }
 
-    llvm::TargetLibraryInfo const & tli = pimpl().ctx.tliwp.getTLI();
-    if (auto alloca = dynamic_cast<llvm::AllocaInst const *>(&v))
+    auto instr = dyn_cast<llvm::Instruction>(&v);
+    if (!instr)
+    {
+        if (auto const_seq = dyn_cast<llvm::ConstantDataSequential>(&v))
+            return const_sym_range(const_seq->getNumElements());
+
+        return { sym_expr(scalar_t(1)), sym_expr::top };
+    }
+
+    switch (instr->getOpcode())
+    {
+    case llvm::Instruction::Alloca:
+    {
+        auto alloca = cast<llvm::AllocaInst>(instr);
         return compute_use_range(alloca->getArraySize(), alloca);
-    else if (auto call = dynamic_cast<llvm::CallInst const *>(&v))
+    }
+    case llvm::Instruction::Call:
     {
+        auto call = cast<llvm::CallInst>(instr);
+        llvm::TargetLibraryInfo const & tli = pimpl().ctx.tliwp.getTLI();
         if (llvm::isAllocationFn(&v, &tli, true))
         {
             auto res = compute_use_range(call->getArgOperand(0), call);   // TODO: can it be improved?
             pimpl().debug_out << "Allocated " << res << "\n";
             return res;
         }
+        break;
     }
-    else if (auto bitcast = dynamic_cast<llvm::BitCastInst const *>(&v))
+    case llvm::Instruction::BitCast:
     {
+        auto bitcast = cast<llvm::BitCastInst>(instr);
         auto src_type = bitcast->getSrcTy();
         auto dst_type = bitcast->getDestTy();
         if (auto src_ptr_type = dyn_cast_or_null<llvm::PointerType>(src_type))
@@ -170,10 +192,10 @@ sym_range analyzer_t::compute_buffer_size_range(llvm::Value const & v)
                 }
             }
         }
+        break;
     }
-    else if (auto const_seq = dynamic_cast<llvm::ConstantDataSequential const *>(&v))
-    {
-        return const_sym_range(const_seq->getNumElements());
+    default:
+        break;
     }
 
     return { sym_expr(scalar_t(1)), sym_expr::top };
@@ -184,23 +206,49 @@ sym_range analyzer_t::compute_buffer_size_range(llvm::Value const & v)
  * ------------------------------------------------
  */
 
-vulnerability_info_t analyzer_t::is_access_vulnerable(llvm::Value const & v,
-                                                      llvm::Instruction const & instr)
+// Only accesses checked with symbolic ranges need the budget, so others and
+// accesses decided before it ran out keep their verdicts.
+boost::optional<vulnerability_info_t> analyzer_t::is_access_vulnerable(llvm::Value const & v,
+                                                                       llvm::Instruction const & instr)
 {
-    auto cached = pimpl().ctx.vulnerability_info.find(&v);
-    if (cached != pimpl().ctx.vulnerability_info.end())
-        return cached->second;
+    if (auto cached = pimpl().ctx.vulnerability_info.find(&v))
+        return *cached;
 
     vulnerability_info_t res = { false, sym_range::empty, sym_range::empty };
-    if (auto gep = dynamic_cast<llvm::GetElementPtrInst const *>(&v))
-        res = is_access_vulnerable_gep(*gep, instr);
+    if (auto gep = dyn_cast<llvm::GetElementPtrInst>(&v))
+    {
+        bool safe = pimpl().prefiltered ? pimpl().prefiltered->count(gep) != 0
+                  : pimpl().prefilter && pimpl().prefilter->is_safe(*gep);
+        if (safe)
+        {
+            pimpl().debug_out << "GEP's base index is in bounds by LLVM's value ranges\n";
+            ++pimpl().prefilter_decided;
+        }
+        else
+        {
+            if (out_of_budget(true))
+                return boost::none;
 
-    pimpl().ctx.vulnerability_info.insert({&v, res});
+            std::vector<trigger_t> triggers;
+            res = is_access_vulnerable_gep(*gep, instr, triggers);
+            // the verdict may be based on ranges computed after the budget ran out
+            if (out_of_budget(true))
+                return boost::none;
+
+            for (trigger_t const & trigger : triggers)
+                pimpl().ctx.triggers->add(gep->getParent()->getParent(), trigger);
+
+            ++pimpl().symbolic_decided;
+        }
+    }
+
+    pimpl().ctx.vulnerability_info.set(&v, res);
     return res;
 }
 
 vulnerability_info_t analyzer_t::is_access_vulnerable_gep(llvm::GetElementPtrInst const & gep,
-                                                          llvm::Instruction const & instr)
+                                                          llvm::Instruction const & instr,
+                                                          std::vector<trigger_t> & triggers)
 {
     auto source_type = gep.getSourceElementType();
     if (!source_type)
@@ -220,11 +268,8 @@ vulnerability_info_t analyzer_t::is_access_vulnerable_gep(llvm::GetElementPtrIns
     sym_range idx_range = compute_use_range(*gep.idx_begin(), &gep);
     pimpl().debug_out << "GEP's base index is in range " << idx_range << "\n";
 
-    check_overflow_res_t res = check_overflow(buf_size, idx_range, instr);
-    for (trigger_t const & trigger : res.triggers)
-    {
-        pimpl().ctx.triggers.emplace(gep.getParent()->getParent(), trigger);
-    }
+    check_overflow_res_t res = check_overflow(buf_size, idx_range, instr, pimpl().options.interprocedural);
+    triggers.insert(triggers.end(), res.triggers.begin(), res.triggers.end());
 
     return { res.verdict, idx_range, buf_size };
 }
@@ -236,17 +281,19 @@ vulnerability_info_t analyzer_t::is_access_vulnerable_gep(llvm::GetElementPtrIns
 
 void analyzer_t::process_instruction(llvm::Instruction const & instr)
 {
-    if (auto load = dynamic_cast<llvm::LoadInst const *>(&instr))
-    {
-        process_load(*load);
-    }
-    else if (auto store = dynamic_cast<llvm::StoreInst const *>(&instr))
-    {
-        process_store(*store);
-    }
-    else if (auto call = dynamic_cast<llvm::CallInst const *>(&instr))
+    switch (instr.getOpcode())
     {
-        process_call(*call);
+    case llvm::Instruction::Load:
+        process_load(cast<llvm::LoadInst>(instr));
+        break;
+    case llvm::Instruction::Store:
+        process_store(cast<llvm::StoreInst>(instr));
+        break;
+    case llvm::Instruction::Call:
+        process_call(cast<llvm::CallInst>(instr));
+        break;
+    default:
+        break;
     }
 }
 
@@ -269,30 +316,43 @@ void analyzer_t::process_store(llvm::StoreInst const & store)
 // Process instruction 'instr' which accesses memory pointed to by value 'ptr_val'.
 void analyzer_t::process_memory_access(llvm::Instruction const & instr, llvm::Value const & ptr_val)
 {
-    vulnerability_info_t vuln_info = is_access_vulnerable(ptr_val, instr);
-    if (vuln_info.decision)
-        report_overflow(instr, vuln_info.idx_range, vuln_info.size_range);
-    else if (boost::logic::indeterminate(vuln_info.decision))
-        report_potential_overflow(instr, vuln_info.idx_range, vuln_info.size_range);
+    boost::optional<vulnerability_info_t> vuln_info = is_access_vulnerable(ptr_val, instr);
+    if (!vuln_info)
+        report_budget_exhausted(instr);
+    else if (vuln_info->decision)
+        report_overflow(instr, vuln_info->idx_range, vuln_info->size_range);
+    else if (boost::logic::indeterminate(vuln_info->decision))
+        report_potential_overflow(instr, vuln_info->idx_range, vuln_info->size_range);
     else
         ++pimpl().total_correct;
 }
 
 void analyzer_t::process_call(llvm::CallInst const & call)
 {
+    if (!pimpl().options.interprocedural)
+        return;
+
     llvm::Function const * called = call.getCalledFunction();
-    auto triggers = pimpl().ctx.triggers.equal_range(called);
-    for (auto it = triggers.first; it != triggers.second; ++it)
+    for (trigger_t const & trigger : pimpl().ctx.triggers->get(called))
     {
-        trigger_t const & trigger = it->second;
         pimpl().debug_out << "Processing trigger: "
                           << trigger.lhs
                           << " <= "
                           << trigger.rhs
                           << "\n"
                              ;
+        if (out_of_budget(true))
+        {
+            report_budget_exhausted(*trigger.instr);
+            continue;
+        }
+
         tribool triggered = is_le_arg(trigger.lhs, trigger.rhs, call);
-        if (triggered)
+        if (out_of_budget(true))
+        {
+            report_budget_exhausted(*trigger.instr);
+        }
+        else if (triggered)
         {
             pimpl().debug_out << "TRIGGERED\n";
             report_overflow(*trigger.instr, boost::none, boost::none);
@@ -331,19 +391,24 @@ tribool analyzer_t::is_le_arg(sym_expr const & e1, sym_expr const & e2, llvm::Ca
 
 sym_range analyzer_t::resolve_expr_arg(sym_expr const & e, llvm::CallInst const & call)
 {
-    sym_atomic_ptr atom_shared = e.to_atom();
+    sym_atomic_ptr atom = e.to_atom();
 
-    std::function<sym_range(sym_atomic const *)> resolve_atom =
-            [this, &call, &resolve_atom, &e](sym_atomic const * atom) -> sym_range
+    // Returns none if some part of the atom can't be resolved, then the
+    // whole expression is left as it is.
+    std::function<boost::optional<sym_range>(sym_atomic const *)> resolve_atom =
+            [this, &call, &resolve_atom](sym_atomic const * atom) -> boost::optional<sym_range>
     {
-        if (auto cnst = dynamic_cast<atomic_const const *>(atom))
+        switch (atom->kind())
+        {
+        case sym_atomic::Const:
         {
-            return { sym_expr(cnst->value()), sym_expr(cnst->value()) };
+            scalar_t value = llvm::cast<atomic_const>(atom)->value();
+            return sym_range{ sym_expr(value), sym_expr(value) };
         }
-        else if (auto atomic = dynamic_cast<atomic_var const *>(atom))
+        case sym_atomic::Var:
         {
-            var_id var = atomic->var();
-            if (auto arg = dynamic_cast<llvm::Argument const *>(var))
+            var_id var = llvm::cast<atomic_var>(atom)->var();
+            if (auto arg = dyn_cast_or_null<llvm::Argument>(var))
             {
                 if (arg->getParent() == call.getCalledFunction())
                 {
@@ -356,16 +421,93 @@ sym_range analyzer_t::resolve_expr_arg(sym_expr const & e, llvm::CallInst const
                     pimpl().warn_out << "Function mismatch in resolve_expr_arg\n";
                 }
             }
-            else if (auto linear = dynamic_cast<atomic_linear const *>(atom))
+            break;
+        }
+        case sym_atomic::Linear:
+        {
+            auto linear = llvm::cast<atomic_linear>(atom);
+            auto res = resolve_atom(linear->atom());
+            if (!res)
+                return boost::none;
+
+            return sym_expr(linear->coeff()) * *res;
+        }
+        case sym_atomic::BinOp:
+            break;
+        case sym_atomic::Sum:
+        {
+            auto sum = llvm::cast<atomic_sum>(atom);
+            auto res = resolve_atom(sum->atom());
+            if (!res)
+                return boost::none;
+
+            sym_range resolved = sym_expr(sum->coeff()) * *res;
+            if (sum->next())
             {
-                return sym_expr(linear->coeff()) * resolve_atom(linear->atom().get());
+                auto next = resolve_atom(sum->next());
+                if (!next)
+                    return boost::none;
+
+                resolved += *next;
             }
+            return resolved;
+        }
         }
 
-        return { e, e };
+        return boost::none;
     };
 
-    return resolve_atom(atom_shared.get());
+    if (auto res = resolve_atom(atom))
+        return *res;
+
+    return { e, e };
+}
+
+/* ------------------------------------------------
+ * Profiles
+ * ------------------------------------------------
+ */
+
+bool parse_analysis_profile(std::string const & name, analysis_profile_t & profile)
+{
+    if (name == "fast")
+        profile = analysis_profile_t::fast;
+    else if (name == "balanced")
+        profile = analysis_profile_t::balanced;
+    else if (name == "thorough")
+        profile = analysis_profile_t::thorough;
+    else
+        return false;
+
+    return true;
+}
+
+analyzer_options_t profile_options(analysis_profile_t profile)
+{
+    analyzer_options_t options;
+    switch (profile)
+    {
+    case analysis_profile_t::fast:
+        // only direct checks with shallow bounds and a short fixpoint
+        options.max_expr_size = 100;
+        options.max_expr_depth = 8;
+        options.max_fixpoint_updates = 4;
+        options.narrowing_passes = 1;
+        options.refine_phi_induction = false;
+        options.gating_conditions = false;
+        options.interprocedural = false;
+        break;
+    case analysis_profile_t::balanced:
+        break;
+    case analysis_profile_t::thorough:
+        options.max_expr_size = 10000;
+        options.max_expr_depth = 256;
+        options.max_fixpoint_updates = 64;
+        options.narrowing_passes = 4;
+        break;
+    }
+
+    return options;
 }
 
 /* ------------------------------------------------
@@ -373,12 +515,24 @@ sym_range analyzer_t::resolve_expr_arg(sym_expr const & e, llvm::CallInst const
  * ------------------------------------------------
  */
 
-analyzer_t::analyzer_t(bool report_indeterminate,
+analyzer_t::analyzer_t(analyzer_options_t const & options,
+                       llvm::raw_ostream & res_out,
+                       llvm::raw_ostream & warn_out,
+                       llvm::raw_ostream & debug_out)
+    : pimpl_(new impl_t(options, res_out, warn_out, debug_out))
+{
+}
+
+analyzer_t::analyzer_t(analyzer_t const & parent,
                        llvm::raw_ostream & res_out,
                        llvm::raw_ostream & warn_out,
                        llvm::raw_ostream & debug_out)
-    : pimpl_(new impl_t(report_indeterminate, res_out, warn_out, debug_out))
+    : pimpl_(new impl_t(parent.pimpl().options, res_out, warn_out, debug_out))
 {
+    pimpl().gsa_builder = parent.pimpl().gsa_builder;
+    pimpl().arena = parent.pimpl().arena;
+    pimpl().ctx.triggers = parent.pimpl().ctx.triggers;
+    pimpl().prefiltered = parent.pimpl().prefiltered;
 }
 
 analyzer_t::~analyzer_t()
@@ -3,9 +3,14 @@
 #include "context.h"
 #include "symbolic.h"
 #include "gsa/cond.h"
+#include "symbolic/arena.h"
+
+#include <chrono>
+#include <string>
 
 #include <boost/filesystem.hpp>
 #include <boost/logic/tribool.hpp>
+#include <boost/optional.hpp>
 
 #include <llvm/IR/Constant.h>
 #include <llvm/IR/Instructions.h>
@@ -17,21 +22,93 @@
 // sense, but in fact we use only basic block from this instruction.
 using program_point_t = llvm::Instruction const *;
 
+struct analyzer_options_t
+{
+    // report situations when overflow is possible, but not surely
+    bool report_indeterminate = false;
+    // number of threads which analyze functions of a module in parallel
+    unsigned jobs = 1;
+    // compute define ranges recursively instead of using worklist engine
+    bool recursive_def_ranges = false;
+    // prove accesses safe with LLVM's value ranges before symbolic analysis
+    bool prefilter = true;
+    // bounds with bigger trees of atoms are replaced with bot/top
+    unsigned max_expr_size = atom_limits_t().max_size;
+    unsigned max_expr_depth = atom_limits_t().max_depth;
+    // limit on the number of updates of every value of a cyclic component
+    unsigned max_fixpoint_updates = 16;
+    // number of narrowing passes over a cyclic component after widening
+    unsigned narrowing_passes = 2;
+    // refine ranges of induction variables compared with '!='
+    bool refine_phi_induction = true;
+    // refine incoming ranges of PHIs with GSA gating conditions
+    bool gating_conditions = true;
+    // build GSA form of a function when its gating conditions are first
+    // needed instead of building it for the whole module up front
+    bool lazy_gsa = true;
+    // check triggers of callees at call sites, otherwise accesses bounded by
+    // arguments are indeterminate
+    bool interprocedural = true;
+    // Budgets of a single function, 0 means unlimited. When one runs out,
+    // accesses of the rest of the function which need symbolic ranges are
+    // reported as indeterminate.
+    unsigned function_time_limit_ms = 0;
+    unsigned function_def_range_limit = 0;
+    // all functions analyzed after this point run out of budget immediately
+    boost::optional<std::chrono::steady_clock::time_point> deadline;
+};
+
+// Presets of the options above which trade precision for speed.
+enum class analysis_profile_t
+{
+    fast,
+    balanced,
+    thorough,
+};
+
+// Returns false if 'name' isn't a name of a profile.
+bool parse_analysis_profile(std::string const & name, analysis_profile_t &);
+
+// Default options with the cost knobs set for the given profile.
+analyzer_options_t profile_options(analysis_profile_t);
+
 struct analyzer_t
 {
-    analyzer_t(bool report_indeterminate,
+    analyzer_t(analyzer_options_t const &,
                llvm::raw_ostream & res_out,
                llvm::raw_ostream & warn_out = llvm::errs(),
                llvm::raw_ostream & debug_out = llvm::outs());
 
-    void analyze_file(boost::filesystem::path const &);
+    // Returns false if the module can't be parsed.
+    bool analyze_file(boost::filesystem::path const &);
+
+    struct totals_t
+    {
+        unsigned overflows;
+        unsigned indeterminate;
+        unsigned correct;
+    };
+
+    totals_t totals() const;
 
     ~analyzer_t();
 
 private:
+    // Worker analyzer which shares module-level state (GSA and triggers)
+    // with the given one, but has its own caches.
+    analyzer_t(analyzer_t const & parent,
+               llvm::raw_ostream & res_out,
+               llvm::raw_ostream & warn_out,
+               llvm::raw_ostream & debug_out);
+
     void analyze_module(llvm::Module const &);
+    void analyze_functions_parallel(std::vector<llvm::Function const *> const &);
+    void clear_module_state();
     void analyze_function(llvm::Function const &);
     void analyze_basic_block(llvm::BasicBlock const &);
+    // Whether the budget of the function being analyzed has run out.
+    // The clock is read on every 256th check or when 'read_clock' is set.
+    bool out_of_budget(bool read_clock = false);
 
     void process_instruction(llvm::Instruction const &);
     void process_getelementptr(llvm::GetElementPtrInst const &);
@@ -52,14 +129,31 @@ private:
     sym_range compute_def_range(var_id const &);
     sym_range compute_use_range(var_id const &, program_point_t);
     void update_def_range(var_id const &);
+    sym_range compute_def_range_worklist(var_id);
+    void compute_def_ranges_cyclic(std::vector<var_id> const &,
+                                   std::vector<std::vector<unsigned>> const & users);
+    bool widen_def_ranges(std::vector<var_id> const &,
+                          std::vector<std::vector<unsigned>> const & users,
+                          std::vector<sym_expr> const & thresholds);
+    void shrink_def_ranges(std::vector<var_id> const &,
+                           std::vector<std::vector<unsigned>> const & users);
+    std::vector<sym_expr> collect_widening_thresholds(std::vector<var_id> const &);
 
     sym_range compute_def_range_const(llvm::Constant const &);
     sym_range compute_def_range_internal(llvm::Value const &);
+    sym_range compute_def_range_bin_op(llvm::BinaryOperator const &);
+    sym_range compute_def_range_phi(llvm::PHINode const &);
+    sym_range compute_def_range_select(llvm::SelectInst const &);
+    sym_range compute_def_range_load(llvm::LoadInst const &);
+    table_index_t const & get_table_index(llvm::ConstantDataSequential const &);
     sym_range compute_buffer_size_range(llvm::Value const &);
-    vulnerability_info_t is_access_vulnerable(llvm::Value const &,
-                                              llvm::Instruction const & instr);
+    // Returns none if the budget has run out before the verdict was found.
+    boost::optional<vulnerability_info_t> is_access_vulnerable(llvm::Value const &,
+                                                               llvm::Instruction const & instr);
+    // Triggers of the access are added to the given vector.
     vulnerability_info_t is_access_vulnerable_gep(llvm::GetElementPtrInst const &,
-                                                  llvm::Instruction const & instr);
+                                                  llvm::Instruction const & instr,
+                                                  std::vector<trigger_t> & triggers);
 
     /* ------------------------------------------------
      * Refinement
@@ -88,8 +182,19 @@ private:
 
     using predicates_t = std::vector<analyzer_t::predicate_t>;
 
-    predicates_t collect_predicates(llvm::BasicBlock const *);
-    predicates_t collect_gating_predicates(var_id v, gating_cond_t const &);
+    // Predicates are cached per function, so the result stays valid until
+    // analysis moves on to another function.
+    predicates_t const & collect_predicates(llvm::BasicBlock const *);
+    void collect_branch_predicates(llvm::BasicBlock const * dominator, llvm::BasicBlock const *,
+                                   predicates_t &);
+    void collect_cmp_predicates(llvm::Value const * cond, bool holds, predicates_t &);
+    void collect_switch_predicates(llvm::SwitchInst const &, llvm::BasicBlock const * successor,
+                                   predicates_t &);
+    void reset_function_cache(llvm::Function const &);
+    // Predicates of the last literal of the gating condition. Conditions are
+    // interned, so they are cached by address until analysis of the module
+    // is finished.
+    predicates_t const & collect_gating_predicates(gating_cond_t const &);
 
     // The first argument is a variable for which we want to refine range.
     // The second argument is symbolic range as it's known before call.
@@ -104,9 +209,11 @@ private:
      */
 
     void report_overflow(llvm::Instruction const &, boost::optional<sym_range const &> idx_range,
-                         boost::optional<sym_range const &> size_range, bool sure = true);
+                         boost::optional<sym_range const &> size_range, bool sure = true,
+                         bool budget_exhausted = false);
     void report_potential_overflow(llvm::Instruction const &, boost::optional<sym_range const &> idx_range,
                                    boost::optional<sym_range const &> size_range);
+    void report_budget_exhausted(llvm::Instruction const &);
 private:
     struct impl_t;
     std::unique_ptr<impl_t> pimpl_;
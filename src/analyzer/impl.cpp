@@ -10,17 +10,27 @@ analyzer_t::impl_t const & analyzer_t::pimpl() const
     return *pimpl_;
 }
 
-analyzer_t::impl_t::impl_t(bool report_indeterminate,
+analyzer_t::impl_t::impl_t(analyzer_options_t const & options,
                            llvm::raw_ostream & res_out,
                            llvm::raw_ostream & warn_out,
                            llvm::raw_ostream & debug_out)
-    : report_indeterminate(report_indeterminate)
+    : options(options)
     , res_out(res_out)
     , warn_out(warn_out)
     , debug_out(debug_out)
     , total_overflows(0)
     , total_indeterminate(0)
     , total_correct(0)
+    , use_range_hits(0)
+    , use_range_misses(0)
+    , prefilter_decided(0)
+    , symbolic_decided(0)
+    , def_range_calls(0)
+    , budget_checks(0)
+    , budget_exhausted(false)
+    , functions_over_budget(0)
+    , gsa_builder(std::make_shared<gsa_builder_t>())
+    , cached_function(nullptr)
 {
 
 }
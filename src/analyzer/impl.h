@@ -1,19 +1,54 @@
 #include "analyzer.h"
 #include "gsa/builder.h"
+#include "analyzer/prefilter.h"
+#include "analyzer/reachability.h"
+#include "symbolic/arena.h"
+
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
 
 struct analyzer_t::impl_t
 {
     context_t ctx;
-    bool report_indeterminate;
+    analyzer_options_t options;
     llvm::raw_ostream & res_out;
     llvm::raw_ostream & warn_out;
     llvm::raw_ostream & debug_out;
     unsigned total_overflows;
     unsigned total_indeterminate;
     unsigned total_correct;
-    gsa_builder_t gsa_builder;
+    // Statistics of the use range cache.
+    unsigned use_range_hits;
+    unsigned use_range_misses;
+    // Number of accesses decided by the prefilter and by symbolic analysis.
+    unsigned prefilter_decided;
+    unsigned symbolic_decided;
+    // Budget of the function being analyzed.
+    boost::optional<std::chrono::steady_clock::time_point> function_deadline;
+    size_t def_range_calls;
+    size_t budget_checks;
+    bool budget_exhausted;
+    unsigned functions_over_budget;
+    // First tier of access checking for the function being analyzed.
+    std::unique_ptr<prefilter_t> prefilter;
+    // Verdicts of the prefilter computed up front when functions are
+    // analyzed in parallel, shared by worker analyzers instead of 'prefilter'.
+    std::shared_ptr<std::unordered_set<llvm::GetElementPtrInst const *> const> prefiltered;
+    // GSA of the module being analyzed, shared by worker analyzers.
+    std::shared_ptr<gsa_builder_t> gsa_builder;
+    // Predicates of gating conditions of the module being analyzed.
+    std::unordered_map<gating_cond_t const *, predicates_t> gating_predicates;
+    // Arena of symbolic atoms of the module being analyzed.
+    std::shared_ptr<atom_arena_t> arena;
+    // Function-level caches. They are valid only for 'cached_function' and
+    // are dropped when analysis moves on to another function.
+    llvm::Function const * cached_function;
+    std::unordered_map<llvm::BasicBlock const *, predicates_t> block_predicates;
+    std::unique_ptr<reachability_t> reachability;
 
-    impl_t(bool report_indeterminate,
+    impl_t(analyzer_options_t const & options,
            llvm::raw_ostream & res_out,
            llvm::raw_ostream & warn_out = llvm::errs(),
            llvm::raw_ostream & debug_out = llvm::outs());
@@ -0,0 +1,50 @@
+#include "numbering.h"
+
+const unsigned value_numbering_t::none;
+
+void value_numbering_t::reset(std::vector<var_id> const & values)
+{
+    slots_.clear();
+    for (var_id v : values)
+        slots_.insert({v, slots_.size()});
+}
+
+value_set_t::value_set_t(value_numbering_t const & numbering)
+    : numbering_(&numbering)
+{
+}
+
+void value_set_t::insert(var_id v)
+{
+    unsigned slot = numbering_->slot(v);
+    if (slot != value_numbering_t::none)
+        slots_.set(slot);
+    else
+        others_.insert(v);
+}
+
+void value_set_t::erase(var_id v)
+{
+    unsigned slot = numbering_->slot(v);
+    if (slot != value_numbering_t::none)
+        slots_.reset(slot);
+    else
+        others_.erase(v);
+}
+
+void value_set_t::renumber()
+{
+    slots_.clear();
+    slots_.resize(numbering_->size());
+    for (auto it = others_.begin(); it != others_.end(); ++it)
+    {
+        if (is_local(*it))
+            others_.erase(it);
+    }
+}
+
+void value_set_t::clear()
+{
+    renumber();
+    others_.clear();
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "common.h"
+
+#include <utility>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+#include <llvm/ADT/BitVector.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/DenseSet.h>
+#include <llvm/IR/Function.h>
+
+// Whether 'v' is an argument or an instruction.
+inline bool is_local(var_id v)
+{
+    return llvm::isa<llvm::Argument>(v) || llvm::isa<llvm::Instruction>(v);
+}
+
+// Dense numbering of values of the function being analyzed. They get slots
+// 0..size()-1, so data attached to them can be kept in flat arrays instead of
+// hash tables.
+struct value_numbering_t
+{
+    static const unsigned none = ~0u;
+
+    // Number the given values. Slots of the previous ones become invalid.
+    void reset(std::vector<var_id> const &);
+
+    // Slot of the value or 'none' if it isn't numbered.
+    unsigned slot(var_id v) const
+    {
+        auto it = slots_.find(v);
+        return it == slots_.end() ? none : it->second;
+    }
+
+    unsigned size() const { return slots_.size(); }
+
+private:
+    llvm::DenseMap<var_id, unsigned> slots_;
+};
+
+// Map from values to 'T'. Numbered values are stored by slot, others
+// (constants, globals, values outside of the slice) in a side table.
+template <class T>
+struct value_map_t
+{
+    explicit value_map_t(value_numbering_t const & numbering)
+        : numbering_(&numbering)
+    {
+    }
+
+    // Returns nullptr if there is no value mapped to 'v'.
+    T const * find(var_id v) const
+    {
+        unsigned slot = numbering_->slot(v);
+        if (slot != value_numbering_t::none)
+            return slots_[slot].get_ptr();
+
+        auto it = others_.find(v);
+        return it == others_.end() ? nullptr : &it->second;
+    }
+
+    void set(var_id v, T value)
+    {
+        unsigned slot = numbering_->slot(v);
+        if (slot != value_numbering_t::none)
+        {
+            slots_[slot] = std::move(value);
+            return;
+        }
+
+        auto it = others_.find(v);
+        if (it != others_.end())
+            it->second = std::move(value);
+        else
+            others_.insert({v, std::move(value)});
+    }
+
+    void erase(var_id v)
+    {
+        unsigned slot = numbering_->slot(v);
+        if (slot != value_numbering_t::none)
+            slots_[slot] = boost::none;
+        else
+            others_.erase(v);
+    }
+
+    // Must be called after the numbering is reset. Values local to the
+    // previous function are dropped, constants and globals are kept.
+    void renumber()
+    {
+        slots_.assign(numbering_->size(), boost::none);
+        for (auto it = others_.begin(); it != others_.end(); ++it)
+        {
+            if (is_local(it->first))
+                others_.erase(it);
+        }
+    }
+
+    void clear()
+    {
+        slots_.assign(numbering_->size(), boost::none);
+        others_.clear();
+    }
+
+private:
+    value_numbering_t const * numbering_;
+    std::vector<boost::optional<T>> slots_;
+    llvm::DenseMap<var_id, T> others_;
+};
+
+// Set of values with the same layout as 'value_map_t'.
+struct value_set_t
+{
+    explicit value_set_t(value_numbering_t const & numbering);
+
+    bool count(var_id v) const
+    {
+        unsigned slot = numbering_->slot(v);
+        if (slot != value_numbering_t::none)
+            return slots_.test(slot);
+
+        return others_.count(v);
+    }
+
+    void insert(var_id);
+    void erase(var_id);
+    void renumber();
+    void clear();
+
+private:
+    value_numbering_t const * numbering_;
+    llvm::BitVector slots_;
+    llvm::DenseSet<var_id> others_;
+};
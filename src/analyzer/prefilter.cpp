@@ -0,0 +1,87 @@
+#include "prefilter.h"
+
+#include <llvm/IR/ConstantRange.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Module.h>
+
+namespace
+{
+
+// Number of elements in the buffer if it's known statically. Mirrors cases of
+// 'analyzer_t::compute_buffer_size_range' which give constants.
+bool constant_buffer_size(llvm::Value const * ptr, uint64_t & size)
+{
+    auto alloca = llvm::dyn_cast<llvm::AllocaInst>(ptr);
+    if (!alloca)
+        return false;
+
+    auto array_size = llvm::dyn_cast<llvm::ConstantInt>(alloca->getArraySize());
+    if (!array_size || array_size->isNegative())
+        return false;
+
+    size = array_size->getZExtValue();
+    return true;
+}
+
+}
+
+prefilter_t::prefilter_t(llvm::Function const & func)
+    : assumptions_(*const_cast<llvm::Function *>(&func))
+    , lvi_(&assumptions_, &func.getParent()->getDataLayout(), nullptr, nullptr)
+{
+}
+
+prefilter_t::~prefilter_t()
+{
+    lvi_.releaseMemory();
+}
+
+bool prefilter_t::is_safe(llvm::GetElementPtrInst const & gep)
+{
+    uint64_t size = 0;
+    if (!constant_buffer_size(gep.getPointerOperand(), size) || !size)
+        return false;
+
+    llvm::Value * idx = *gep.idx_begin();
+    if (!idx->getType()->isIntegerTy())
+        return false;
+
+    auto instr = const_cast<llvm::GetElementPtrInst *>(&gep);
+    llvm::ConstantRange range = lvi_.getConstantRange(idx, instr->getParent(), instr);
+    if (range.isEmptySet())
+        return false;
+
+    // index is treated as signed, like in symbolic ranges
+    return range.getSignedMin().isNonNegative()
+            && range.getSignedMax().ult(size);
+}
+
+std::unordered_set<llvm::GetElementPtrInst const *> prefilter_functions(
+        std::vector<llvm::Function const *> const & functions)
+{
+    std::unordered_set<llvm::GetElementPtrInst const *> safe;
+    for (llvm::Function const * f : functions)
+    {
+        if (f->isDeclaration())
+            continue;
+
+        prefilter_t prefilter(*f);
+        for (auto const & bb : *f)
+        {
+            for (auto const & instr : bb)
+            {
+                llvm::Value const * ptr = nullptr;
+                if (auto load = llvm::dyn_cast<llvm::LoadInst>(&instr))
+                    ptr = load->getPointerOperand();
+                else if (auto store = llvm::dyn_cast<llvm::StoreInst>(&instr))
+                    ptr = store->getPointerOperand();
+
+                auto gep = llvm::dyn_cast_or_null<llvm::GetElementPtrInst>(ptr);
+                if (gep && !safe.count(gep) && prefilter.is_safe(*gep))
+                    safe.insert(gep);
+            }
+        }
+    }
+
+    return safe;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <unordered_set>
+#include <vector>
+
+#include <llvm/Analysis/AssumptionCache.h>
+#include <llvm/Analysis/LazyValueInfo.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Instructions.h>
+
+// First tier of checking memory accesses.
+//
+// It uses LLVM's lazy value info to prove that the index of an access to a
+// buffer of constant size is in bounds. This is much cheaper than symbolic
+// ranges and covers most accesses to stack arrays. Accesses which it can't
+// prove safe are left to the symbolic engine.
+//
+// Information is computed lazily and is valid for a single function.
+struct prefilter_t
+{
+    explicit prefilter_t(llvm::Function const &);
+    ~prefilter_t();
+
+    prefilter_t(prefilter_t const &) = delete;
+    prefilter_t & operator=(prefilter_t const &) = delete;
+
+    // Whether the base index of GEP is known to be in bounds of its buffer.
+    bool is_safe(llvm::GetElementPtrInst const &);
+
+private:
+    llvm::AssumptionCache assumptions_;
+    llvm::LazyValueInfo lvi_;
+};
+
+// GEPs used as pointers of loads and stores of the given functions which are
+// proven safe by the prefilter. LLVM's analyses register value handles in the
+// context of the module, which isn't thread safe, so functions which are
+// analyzed in parallel are prefiltered serially up front.
+std::unordered_set<llvm::GetElementPtrInst const *> prefilter_functions(
+        std::vector<llvm::Function const *> const &);
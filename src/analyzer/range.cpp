@@ -1,5 +1,12 @@
 #include "analyzer.h"
 #include "analyzer/impl.h"
+#include "analyzer/scc.h"
+#include "analyzer/slice.h"
+#include "analyzer/table.h"
+
+#include <algorithm>
+#include <deque>
+#include <vector>
 
 #include <boost/logic/tribool.hpp>
 
@@ -14,8 +21,24 @@ using boost::tribool;
 
 sym_range analyzer_t::compute_use_range(var_id const & v, program_point_t p)
 {
+    context_t & ctx = pimpl().ctx;
+    use_range_key_t key(v, p ? p->getParent() : nullptr);
+    auto it = ctx.use_ranges.find(key);
+    if (it != ctx.use_ranges.end())
+    {
+        ++pimpl().use_range_hits;
+        return it->second;
+    }
+
+    ++pimpl().use_range_misses;
+    unsigned temporary_reads = ctx.temporary_reads;
     sym_range r = compute_def_range(v);
-    return refine_def_range(v, std::move(r), p);
+    r = refine_def_range(v, std::move(r), p);
+    // a range computed after the budget ran out is a fallback, not a result
+    if (ctx.temporary_reads == temporary_reads && !ctx.widening_depth && !out_of_budget())
+        ctx.use_ranges.insert({key, r});
+
+    return r;
 }
 
 sym_range analyzer_t::compute_def_range(var_id const & v)
@@ -23,36 +46,50 @@ sym_range analyzer_t::compute_def_range(var_id const & v)
     if (!v)
         return var_sym_range(v);
 
-    auto it = pimpl().ctx.def_ranges.find(v);
-    if (it != pimpl().ctx.def_ranges.end())
-        return it->second;
+    // Instructions outside of the access slice can't affect checks, so they
+    // are left unknown.
+    if (llvm::isa<llvm::Instruction>(v) && pimpl().ctx.numbering.slot(v) == value_numbering_t::none)
+        return var_sym_range(v);
+
+    // Ranges computed after the budget has run out are never cached, so
+    // they don't leak into other functions.
+    ++pimpl().def_range_calls;
+    if (out_of_budget())
+        return sym_range::full;
+
+    if (auto cached = pimpl().ctx.def_ranges.find(v))
+    {
+        if (pimpl().ctx.new_val_set.count(v))
+            ++pimpl().ctx.temporary_reads;
+        return *cached;
+    }
 
-    if (auto llvm_arg = dynamic_cast<llvm::Argument const *>(v))
+    if (auto llvm_arg = llvm::dyn_cast_or_null<llvm::Argument>(v))
     {
         auto res = var_sym_range(llvm_arg);
-        pimpl().ctx.def_ranges.emplace(v, res);
+        pimpl().ctx.def_ranges.set(v, res);
         return res;
     }
 
-    if (auto const_v = dynamic_cast<llvm::Constant const *>(v))
+    if (auto const_v = llvm::dyn_cast_or_null<llvm::Constant>(v))
     {
         auto res = compute_def_range_const(*const_v);
-        pimpl().ctx.def_ranges.emplace(v, res);
+        pimpl().ctx.def_ranges.set(v, res);
         return res;
     }
 
-    pimpl().ctx.new_val_set.insert(v);
-    pimpl().ctx.def_ranges.emplace(v, sym_range::full);
+    if (!pimpl().options.recursive_def_ranges)
+        return compute_def_range_worklist(v);
 
-    auto range = compute_def_range_internal(*v);
-    pimpl().ctx.def_ranges.erase(v);
-    pimpl().ctx.def_ranges.emplace(v, std::move(range));
+    pimpl().ctx.new_val_set.insert(v);
+    pimpl().ctx.def_ranges.set(v, sym_range::full);
+    pimpl().ctx.def_ranges.set(v, compute_def_range_internal(*v));
 
     update_def_range(v);
     pimpl().ctx.new_val_set.erase(v);
 
-    auto res_it = pimpl().ctx.def_ranges.find(v);
-    return res_it == pimpl().ctx.def_ranges.end() ? sym_range::full : res_it->second;
+    auto res = pimpl().ctx.def_ranges.find(v);
+    return res ? *res : sym_range::full;
 }
 
 void analyzer_t::update_def_range(var_id const & v)
@@ -60,24 +97,320 @@ void analyzer_t::update_def_range(var_id const & v)
     if (!v)
         return;
 
+    // only values of the slice are computed, so other users are skipped
+    value_numbering_t const & numbering = pimpl().ctx.numbering;
     for (var_id w : v->users())
     {
-        if (!pimpl().ctx.new_val_set.count(w))
+        if (numbering.slot(w) == value_numbering_t::none || !pimpl().ctx.new_val_set.count(w))
             continue;
 
         sym_range w_def_range = compute_def_range_internal(*w);
-        auto cached_iter = pimpl().ctx.def_ranges.find(w);
-        sym_range cached = cached_iter == pimpl().ctx.def_ranges.end() ? sym_range::full : cached_iter->second;
+        auto cached_ptr = pimpl().ctx.def_ranges.find(w);
+        sym_range cached = cached_ptr ? *cached_ptr : sym_range::full;
         w_def_range &= cached;
         if (w_def_range != cached)
         {
-            pimpl().ctx.def_ranges.erase(w);
-            pimpl().ctx.def_ranges.emplace(w, w_def_range);
+            pimpl().ctx.def_ranges.set(w, w_def_range);
             update_def_range(w);
         }
     }
 }
 
+// Computes define range of 'v' and of all values it depends on without
+// recursion. Dependency graph is split into strongly connected components,
+// which are processed in topological order, so every value is computed after
+// its operands. Cyclic components are solved with widening and narrowing.
+sym_range analyzer_t::compute_def_range_worklist(var_id v)
+{
+    context_t & ctx = pimpl().ctx;
+
+    // Collect values which aren't computed yet. Arguments and constants are
+    // cheap to compute when they are needed, and values which are being
+    // computed by an outer call already have a temporary range.
+    std::vector<var_id> nodes = {v};
+    llvm::DenseMap<var_id, unsigned> ids = {{v, 0}};
+    std::vector<std::vector<unsigned>> deps;
+    std::vector<var_id> operands;
+    for (unsigned i = 0; i != nodes.size(); ++i)
+    {
+        operands.clear();
+        def_range_operands(*nodes[i], operands);
+        deps.emplace_back();
+        for (var_id op : operands)
+        {
+            if (!llvm::isa<llvm::Instruction>(op) || ctx.def_ranges.find(op))
+                continue;
+
+            auto inserted = ids.insert({op, nodes.size()});
+            if (inserted.second)
+                nodes.push_back(op);
+
+            deps[i].push_back(inserted.first->second);
+        }
+    }
+
+    unsigned const n = nodes.size();
+    unsigned scc_count;
+    std::vector<unsigned> scc = find_sccs(n, [&deps](unsigned u) -> std::vector<unsigned> const & { return deps[u]; },
+                                          scc_count);
+
+    // Nodes are visited in breadth-first order, so when iterated backwards,
+    // operands usually come before their users inside a component too.
+    std::vector<std::vector<unsigned>> members(scc_count);
+    std::vector<std::vector<unsigned>> users(n);
+    for (unsigned u = n; u-- != 0; )
+    {
+        members[scc[u]].push_back(u);
+        for (unsigned w : deps[u])
+        {
+            if (scc[w] == scc[u])
+                users[w].push_back(u);
+        }
+    }
+
+    std::vector<unsigned> local(n);
+    for (std::vector<unsigned> const & component : members)
+    {
+        unsigned front = component.front();
+        bool cyclic = component.size() > 1
+                || std::count(deps[front].begin(), deps[front].end(), front);
+        if (!cyclic)
+        {
+            // Component could be computed meanwhile by a nested call made
+            // by refinement.
+            var_id w = nodes[front];
+            if (ctx.def_ranges.find(w))
+                continue;
+
+            ctx.new_val_set.insert(w);
+            ctx.def_ranges.set(w, sym_range::full);
+            ctx.def_ranges.set(w, compute_def_range_internal(*w));
+            ctx.new_val_set.erase(w);
+            continue;
+        }
+
+        std::vector<var_id> values;
+        for (unsigned u : component)
+        {
+            local[u] = values.size();
+            values.push_back(nodes[u]);
+        }
+
+        std::vector<std::vector<unsigned>> component_users(values.size());
+        for (unsigned u : component)
+        {
+            for (unsigned w : users[u])
+                component_users[local[u]].push_back(local[w]);
+        }
+
+        compute_def_ranges_cyclic(values, component_users);
+    }
+
+    auto res = ctx.def_ranges.find(v);
+    sym_range result = res ? *res : sym_range::full;
+
+    // Ranges computed while some cyclic component is being widened may
+    // depend on its unstable ranges, so they aren't kept.
+    if (ctx.widening_depth)
+    {
+        for (var_id w : nodes)
+            ctx.def_ranges.erase(w);
+    }
+
+    return result;
+}
+
+// Computes define ranges of values which form a cyclic component of the
+// dependency graph. 'users[i]' are indices of values using 'values[i]'.
+//
+// Ranges grow from empty ones. Every cycle goes through a phi node and
+// ranges of phi nodes are widened with thresholds taken from predicates on
+// the values, so this converges quickly. Result is then improved by a few
+// narrowing passes.
+//
+// Intersection of bounds which can't be compared gives an empty bound, so
+// when growing scalar ranges are refined with symbolic predicates, widening
+// is abandoned and ranges are narrowed down from full ones instead.
+void analyzer_t::compute_def_ranges_cyclic(std::vector<var_id> const & values,
+                                          std::vector<std::vector<unsigned>> const & users)
+{
+    context_t & ctx = pimpl().ctx;
+
+    // Thresholds are computed by nested calls, which may depend on these
+    // values again, as in a loop with two pointers moving towards each
+    // other. They read temporary full ranges instead of solving this
+    // component once more, so ranges they compute aren't kept.
+    for (var_id w : values)
+    {
+        ctx.new_val_set.insert(w);
+        ctx.def_ranges.set(w, sym_range::full);
+    }
+
+    ++ctx.widening_depth;
+    std::vector<sym_expr> thresholds = collect_widening_thresholds(values);
+    --ctx.widening_depth;
+
+    if (widen_def_ranges(values, users, thresholds))
+    {
+        for (unsigned pass = 0; pass != pimpl().options.narrowing_passes; ++pass)
+        {
+            for (var_id w : values)
+            {
+                sym_range prev = *ctx.def_ranges.find(w);
+                ctx.def_ranges.set(w, narrow(prev, compute_def_range_internal(*w)));
+            }
+        }
+    }
+    else
+    {
+        pimpl().debug_out << "Widening of " << values.size() << " cyclic values failed\n";
+        shrink_def_ranges(values, users);
+    }
+
+    for (var_id w : values)
+        ctx.new_val_set.erase(w);
+}
+
+// Ascending iteration with widening. Returns false if it hasn't stabilized
+// or produced malformed ranges, in which case ranges are meaningless.
+bool analyzer_t::widen_def_ranges(std::vector<var_id> const & values,
+                                  std::vector<std::vector<unsigned>> const & users,
+                                  std::vector<sym_expr> const & thresholds)
+{
+    context_t & ctx = pimpl().ctx;
+    unsigned const n = values.size();
+    for (var_id w : values)
+        ctx.def_ranges.set(w, sym_range::empty);
+
+    std::deque<unsigned> worklist;
+    std::vector<bool> queued(n, true);
+    for (unsigned u = 0; u != n; ++u)
+        worklist.push_back(u);
+
+    ++ctx.widening_depth;
+    size_t budget = size_t(pimpl().options.max_fixpoint_updates) * n;
+    bool malformed = false;
+    while (!worklist.empty() && budget && !malformed)
+    {
+        --budget;
+        unsigned u = worklist.front();
+        worklist.pop_front();
+        queued[u] = false;
+
+        sym_range prev = *ctx.def_ranges.find(values[u]);
+        sym_range next = compute_def_range_internal(*values[u]);
+        malformed = next.lo.is_top() != next.hi.is_bot();
+        if (llvm::isa<llvm::PHINode>(values[u]))
+            next = widen(prev, prev | next, thresholds);
+
+        if (next == prev)
+            continue;
+
+        ctx.def_ranges.set(values[u], std::move(next));
+        for (unsigned w : users[u])
+        {
+            if (!queued[w])
+            {
+                queued[w] = true;
+                worklist.push_back(w);
+            }
+        }
+    }
+    --ctx.widening_depth;
+
+    return worklist.empty() && !malformed;
+}
+
+// Descending iteration from full ranges. Like 'update_def_range', but ranges
+// are recomputed only when ranges they depend on change. Number of updates
+// is limited, ranges computed so far are still correct.
+void analyzer_t::shrink_def_ranges(std::vector<var_id> const & values,
+                                   std::vector<std::vector<unsigned>> const & users)
+{
+    context_t & ctx = pimpl().ctx;
+    unsigned const n = values.size();
+    for (var_id w : values)
+        ctx.def_ranges.set(w, sym_range::full);
+
+    for (var_id w : values)
+        ctx.def_ranges.set(w, compute_def_range_internal(*w));
+
+    std::deque<unsigned> worklist;
+    std::vector<bool> queued(n, true);
+    for (unsigned u = 0; u != n; ++u)
+        worklist.push_back(u);
+
+    size_t budget = size_t(pimpl().options.max_fixpoint_updates) * n;
+    while (!worklist.empty() && budget)
+    {
+        --budget;
+        unsigned u = worklist.front();
+        worklist.pop_front();
+        queued[u] = false;
+
+        sym_range cached = *ctx.def_ranges.find(values[u]);
+        sym_range updated = compute_def_range_internal(*values[u]);
+        updated &= cached;
+        if (updated == cached)
+            continue;
+
+        ctx.def_ranges.set(values[u], std::move(updated));
+        for (unsigned w : users[u])
+        {
+            if (!queued[w])
+            {
+                queued[w] = true;
+                worklist.push_back(w);
+            }
+        }
+    }
+}
+
+// Bounds of values which are compared with the given ones. For a loop they
+// are usually bounds of its induction variables.
+std::vector<sym_expr> analyzer_t::collect_widening_thresholds(std::vector<var_id> const & values)
+{
+    llvm::DenseSet<var_id> members(values.begin(), values.end());
+    llvm::DenseSet<llvm::BasicBlock const *> blocks;
+    std::vector<sym_expr> thresholds;
+    sym_expr one(scalar_t(1));
+    for (var_id v : values)
+    {
+        auto instr = llvm::dyn_cast<llvm::Instruction>(v);
+        if (!instr || !blocks.insert(instr->getParent()).second)
+            continue;
+
+        // copy, because computing bounds can add predicates to the cache
+        predicates_t predicates = collect_predicates(instr->getParent());
+        for (predicate_t const & pred : predicates)
+        {
+            var_id bound;
+            if (members.count(pred.lhs))
+                bound = pred.rhs;
+            else if (members.count(pred.rhs))
+                bound = pred.lhs;
+            else
+                continue;
+
+            if (members.count(bound))
+                continue;
+
+            sym_range bound_range = compute_def_range(bound);
+            for (sym_expr const & e : {bound_range.lo, bound_range.hi})
+            {
+                if (e.is_top() || e.is_bot())
+                    continue;
+
+                thresholds.push_back(e - one);
+                thresholds.push_back(e);
+                thresholds.push_back(e + one);
+            }
+        }
+    }
+
+    return thresholds;
+}
+
 sym_range analyzer_t::compute_def_range_const(llvm::Constant const & c)
 {
     llvm::Type * t = c.getType();
@@ -103,130 +436,171 @@ sym_range analyzer_t::compute_def_range_const(llvm::Constant const & c)
 
 sym_range analyzer_t::compute_def_range_internal(llvm::Value const & v)
 {
-    if (auto bin_op = dynamic_cast<llvm::BinaryOperator const *>(&v))
-    {
-        var_id op0 = bin_op->getOperand(0), op1 = bin_op->getOperand(1);
-        sym_range op0_range = compute_use_range(op0, bin_op),
-                  op1_range = compute_use_range(op1, bin_op);
-        if (bin_op->getOpcode() == llvm::BinaryOperator::Add)
-            return op0_range + op1_range;
-        else if (bin_op->getOpcode() == llvm::BinaryOperator::Sub)
-            return op0_range - op1_range;
-        else if (bin_op->getOpcode() == llvm::BinaryOperator::Mul)
-            return op0_range * op1_range;
-        else if (bin_op->getOpcode() == llvm::BinaryOperator::SDiv)
-            return op0_range / op1_range;
-    }
-    else if (auto phi = dynamic_cast<llvm::PHINode const *>(&v))
-    {
-        sym_range r(sym_range::empty);
-        size_t counter = 0;
-        for (var_id inc_v : phi->incoming_values())
-        {
-            sym_range current_range = compute_use_range(inc_v, phi);
-            if (auto gating = pimpl().gsa_builder.get_gating_condition(*phi, counter))
-                current_range = refine_def_range_gating(inc_v, current_range, *gating);
+    if (auto instr = llvm::dyn_cast<llvm::Instruction>(&v))
+    {
+        if (auto bin_op = llvm::dyn_cast<llvm::BinaryOperator>(instr))
+            return compute_def_range_bin_op(*bin_op);
 
-            r |= current_range;
-            ++counter;
+        switch (instr->getOpcode())
+        {
+        case llvm::Instruction::PHI:
+            return compute_def_range_phi(llvm::cast<llvm::PHINode>(*instr));
+        case llvm::Instruction::Select:
+            if (instr->getType()->isIntegerTy())
+                return compute_def_range_select(llvm::cast<llvm::SelectInst>(*instr));
+            break;
+        case llvm::Instruction::Load:
+            return compute_def_range_load(llvm::cast<llvm::LoadInst>(*instr));
+        case llvm::Instruction::SExt:
+        case llvm::Instruction::ZExt:
+            return compute_use_range(instr->getOperand(0), instr);
+        default:
+            break;
         }
+    }
 
-        if (phi->getNumIncomingValues() == 2)
+    if (auto type = v.getType())
+    {
+        if (type->isIntegerTy())
         {
-            var_id inc_v0 = phi->getIncomingValue(0);
-            var_id inc_v1 = phi->getIncomingValue(1);
-
-            auto test_value = [&r, phi, this](var_id dependent, var_id another)
-            {
-                switch (does_monotonically_depend(dependent, phi))
-                {
-                case MONOTONY_INC:
-                {
-                    predicate_t predicate = {PT_LE, another, phi, phi};
-                    r = refine_def_range_internal(phi, r, predicate);
-                    break;
-                }
-                case MONOTONY_DEC:
-                {
-                    predicate_t predicate = {PT_LE, phi, another, phi};
-                    r = refine_def_range_internal(phi, r, predicate);
-                    break;
-                }
-                default:
-                    break;
-                }
-            };
-
-            test_value(inc_v0, inc_v1);
-            test_value(inc_v1, inc_v0);
+            llvm::IntegerType * int_type = static_cast<llvm::IntegerType *>(type);
+            auto bits = int_type->getBitMask();
+            scalar_t max(bits >> 1);
+            scalar_t min(-max - 1);
+            return {sym_expr(min), sym_expr(max)};
         }
+    }
 
-        return r;
+    return var_sym_range(&v);
+}
+
+sym_range analyzer_t::compute_def_range_bin_op(llvm::BinaryOperator const & bin_op)
+{
+    var_id op0 = bin_op.getOperand(0), op1 = bin_op.getOperand(1);
+    sym_range op0_range = compute_use_range(op0, &bin_op),
+              op1_range = compute_use_range(op1, &bin_op);
+    switch (bin_op.getOpcode())
+    {
+    case llvm::BinaryOperator::Add:
+        return op0_range + op1_range;
+    case llvm::BinaryOperator::Sub:
+        return op0_range - op1_range;
+    case llvm::BinaryOperator::Mul:
+        return op0_range * op1_range;
+    case llvm::BinaryOperator::SDiv:
+        return op0_range / op1_range;
+    default:
+        return var_sym_range(&bin_op);
     }
-    else if (auto load = dynamic_cast<llvm::LoadInst const *>(&v))
+}
+
+sym_range analyzer_t::compute_def_range_phi(llvm::PHINode const & phi)
+{
+    sym_range r(sym_range::empty);
+    size_t counter = 0;
+    for (var_id inc_v : phi.incoming_values())
     {
-        if (auto gep = dynamic_cast<llvm::GetElementPtrInst const *>(load->getPointerOperand()))
+        sym_range current_range = compute_use_range(inc_v, &phi);
+        if (pimpl().options.gating_conditions)
         {
-            if (gep->getNumIndices() == 2)  // TODO: check that 0-th index is 0
-            {
-                llvm::ConstantDataSequential const * const_seq =
-                        dynamic_cast<llvm::ConstantDataSequential const *>(gep->getPointerOperand());
-                if (!const_seq)
-                {
-                    if (auto gv = dynamic_cast<llvm::GlobalVariable const *>(gep->getPointerOperand()))
-                    {
-                        if (gv->isConstant())
-                            const_seq = dynamic_cast<llvm::ConstantDataSequential const *>(gv->getInitializer());
-                    }
-                }
-                if (const_seq)
-                {
-                    auto begin = gep->idx_begin();
-                    begin++;
-                    sym_range idx_range = compute_use_range(*begin, gep);
-                    if (auto scalar_r = to_scalar_range(idx_range))
-                    {
-                        if (scalar_r->second < 0 || scalar_r->first >= const_seq->getNumElements())
-                        {
-                            load->getDebugLoc().print(pimpl().res_out);
-                            pimpl().res_out << "vulnerable access of constant aggregate\n";
-                        }
-                        else
-                        {
-                            sym_range res = sym_range::empty;
-                            for (unsigned i = scalar_r->first; i <= scalar_r->second; ++i)
-                            {
-                                scalar_t n(const_seq->getElementAsInteger(i));
-                                sym_expr e(n);
-                                res.lo = meet(res.lo, e);
-                                res.hi = join(res.hi, e);
-                            }
-                            return res;
-                        }
-                    }
-                }
-            }
+            if (auto gating = pimpl().gsa_builder->get_gating_condition(phi, counter))
+                current_range = refine_def_range_gating(inc_v, current_range, *gating);
         }
+
+        r |= current_range;
+        ++counter;
     }
-    else if (auto sext = dynamic_cast<llvm::SExtInst const *>(&v))
+
+    if (phi.getNumIncomingValues() == 2)
     {
-        return compute_use_range(sext->getOperand(0), sext);
+        var_id inc_v0 = phi.getIncomingValue(0);
+        var_id inc_v1 = phi.getIncomingValue(1);
+
+        auto test_value = [&r, &phi, this](var_id dependent, var_id another)
+        {
+            switch (does_monotonically_depend(dependent, &phi))
+            {
+            case MONOTONY_INC:
+            {
+                predicate_t predicate = {PT_LE, another, &phi, &phi};
+                r = refine_def_range_internal(&phi, r, predicate);
+                break;
+            }
+            case MONOTONY_DEC:
+            {
+                predicate_t predicate = {PT_LE, &phi, another, &phi};
+                r = refine_def_range_internal(&phi, r, predicate);
+                break;
+            }
+            default:
+                break;
+            }
+        };
+
+        test_value(inc_v0, inc_v1);
+        test_value(inc_v1, inc_v0);
     }
-    else if (auto sext = dynamic_cast<llvm::ZExtInst const *>(&v))
+
+    return r;
+}
+
+sym_range analyzer_t::compute_def_range_select(llvm::SelectInst const & select)
+{
+    sym_range r(sym_range::empty);
+    llvm::Value const * values[] = {select.getTrueValue(), select.getFalseValue()};
+    for (unsigned i = 0; i != 2; ++i)
     {
-        return compute_use_range(sext->getOperand(0), sext);
+        sym_range current_range = compute_use_range(values[i], &select);
+        if (pimpl().options.gating_conditions)
+        {
+            if (auto gating = pimpl().gsa_builder->get_gating_condition(select, i))
+                current_range = refine_def_range_gating(values[i], current_range, *gating);
+        }
+
+        r |= current_range;
     }
-    else if (auto type = v.getType())
+
+    return r;
+}
+
+table_index_t const & analyzer_t::get_table_index(llvm::ConstantDataSequential const & table)
+{
+    auto & index = pimpl().ctx.table_indices[&table];
+    if (!index)
+        index.reset(new table_index_t(table));
+
+    return *index;
+}
+
+sym_range analyzer_t::compute_def_range_load(llvm::LoadInst const & load)
+{
+    llvm::ConstantDataSequential const * const_seq = nullptr;
+    if (auto gep = constant_table_access(load, const_seq))
     {
-        if (type->isIntegerTy())
+        auto begin = gep->idx_begin();
+        begin++;
+        sym_range idx_range = compute_use_range(*begin, gep);
+        if (auto scalar_r = to_scalar_range(idx_range))
         {
-            llvm::IntegerType * int_type = static_cast<llvm::IntegerType *>(type);
-            auto bits = int_type->getBitMask();
-            scalar_t max(bits >> 1);
-            scalar_t min(-max - 1);
-            return {sym_expr(min), sym_expr(max)};
+            if (scalar_r->second < 0 || scalar_r->first >= const_seq->getNumElements())
+            {
+                load.getDebugLoc().print(pimpl().res_out);
+                pimpl().res_out << "vulnerable access of constant aggregate\n";
+            }
+            else if (const_seq->getElementType()->isIntegerTy())
+            {
+                table_index_t const & index = get_table_index(*const_seq);
+                size_t first = std::max<scalar_t>(scalar_r->first, 0),
+                       last = std::min<scalar_t>(scalar_r->second, index.size() - 1);
+                // no element can be loaded
+                if (first > last)
+                    return sym_range::empty;
+
+                auto r = index.minmax(first, last);
+                return {sym_expr(r.first), sym_expr(r.second)};
+            }
         }
     }
 
-    return var_sym_range(&v);
+    return var_sym_range(&load);
 }
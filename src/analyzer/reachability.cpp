@@ -0,0 +1,103 @@
+#include "reachability.h"
+#include "scc.h"
+
+#include <llvm/IR/CFG.h>
+
+reachability_t::reachability_t(llvm::Function const & func, llvm::DominatorTree const & dom_tree)
+    : dom_tree_(dom_tree)
+{
+    std::vector<llvm::BasicBlock const *> blocks;
+    for (auto const & bb : func)
+    {
+        numbers_.emplace(&bb, blocks.size());
+        blocks.push_back(&bb);
+    }
+
+    unsigned const n = blocks.size();
+    std::vector<std::vector<unsigned>> succs(n);
+    for (unsigned v = 0; v != n; ++v)
+    {
+        if (!dom_tree_.isReachableFromEntry(blocks[v]))
+            continue;
+
+        for (llvm::BasicBlock const * succ : llvm::successors(blocks[v]))
+        {
+            if (!dom_tree_.dominates(succ, blocks[v]))
+                succs[v].push_back(numbers_.at(succ));
+        }
+    }
+
+    // Without back edges reducible CFG is acyclic, but irreducible one is not,
+    // so we work with strongly connected components.
+    unsigned scc_count;
+    scc_ = find_sccs(n, [&succs](unsigned v) -> std::vector<unsigned> const & { return succs[v]; }, scc_count);
+
+    // Successors of a component always have smaller numbers, so a single pass
+    // in increasing order computes the closure.
+    std::vector<std::vector<unsigned>> members(scc_count);
+    for (unsigned v = 0; v != n; ++v)
+        members[scc_[v]].push_back(v);
+
+    reachable_.assign(scc_count, llvm::BitVector(n));
+    for (unsigned c = 0; c != scc_count; ++c)
+    {
+        llvm::BitVector & bits = reachable_[c];
+        for (unsigned v : members[c])
+        {
+            bits.set(v);
+            for (unsigned w : succs[v])
+            {
+                if (scc_[w] != c)
+                    bits |= reachable_[scc_[w]];
+            }
+        }
+    }
+}
+
+bool reachability_t::is_reachable(llvm::BasicBlock const * source, llvm::BasicBlock const * dest,
+                                  llvm::BasicBlock const * checkpoint) const
+{
+    // When the destination is unreachable, it's dominated from everywhere,
+    // regardless of whether there's a path between the two blocks.
+    if (!dom_tree_.isReachableFromEntry(dest))
+        return false;
+
+    if (source == dest)
+        return true;
+
+    if (!dom_tree_.isReachableFromEntry(source) || source == checkpoint)
+        return false;
+
+    auto s = numbers_.find(source);
+    auto d = numbers_.find(dest);
+    if (s == numbers_.end() || d == numbers_.end())
+        return true;
+
+    if (checkpoint && dom_tree_.dominates(checkpoint, dest))
+    {
+        // Path from 'source' which avoids 'checkpoint' can reach 'dest' only
+        // if 'source' is in the region dominated by 'checkpoint'.
+        if (!dom_tree_.properlyDominates(checkpoint, source))
+            return false;
+
+        bool is_successor = false;
+        for (llvm::BasicBlock const * succ : llvm::successors(checkpoint))
+            is_successor = is_successor || succ == source;
+
+        if (!is_successor)
+            return true;
+    }
+    else
+    {
+        // Back edges can't be dropped without dominance, so conservatively
+        // answer true.
+        return true;
+    }
+
+    return is_reachable_acyclic(s->second, d->second);
+}
+
+bool reachability_t::is_reachable_acyclic(unsigned source, unsigned dest) const
+{
+    return reachable_[scc_[source]].test(dest);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include <llvm/ADT/BitVector.h>
+#include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/Function.h>
+
+// Reachability index over basic blocks of a single function.
+//
+// It stores transitive closure of the CFG without back edges (edges whose
+// target dominates their source) as dense bitsets over block numbers, one
+// bitset per strongly connected component. Queries are constant time.
+//
+// Dominator tree passed to the constructor must outlive the index.
+struct reachability_t
+{
+    reachability_t(llvm::Function const &, llvm::DominatorTree const &);
+
+    // Whether 'dest' is reachable from 'source' on a path which doesn't go
+    // through 'checkpoint'. Like in 'llvm::isPotentiallyReachable' the answer
+    // may be conservatively true, but never conservatively false.
+    //
+    // Result is exact when 'checkpoint' dominates 'dest', 'source' is a
+    // successor of 'checkpoint' and CFG is reducible: every such path stays
+    // in the region dominated by 'checkpoint' and a loop it goes around has
+    // its header on the path before the back edge, so back edges can be
+    // dropped from it. For other sources a dropped back edge may be the only
+    // way to 'dest', so the answer is conservatively true.
+    bool is_reachable(llvm::BasicBlock const * source, llvm::BasicBlock const * dest,
+                      llvm::BasicBlock const * checkpoint) const;
+
+private:
+    bool is_reachable_acyclic(unsigned source, unsigned dest) const;
+
+private:
+    llvm::DominatorTree const & dom_tree_;
+    std::unordered_map<llvm::BasicBlock const *, unsigned> numbers_;
+    std::vector<unsigned> scc_;
+    std::vector<llvm::BitVector> reachable_;
+};
@@ -3,6 +3,7 @@
 
 #include <iterator>
 
+#include <llvm/ADT/SmallVector.h>
 #include <llvm/ADT/StringRef.h>
 #include <llvm/Pass.h>
 #include <llvm/Analysis/MemoryBuiltins.h>
@@ -20,281 +21,259 @@
  * ------------------------------------------------
  */
 
-// Custom version of 'llvm::isPotentiallyReachable'.
-// It takes three basic blocks: source, destination and checkpoint.
-// It works like 'llvm::isPotentiallyReachable' but ignores edges from
-// checkpoint to destination.
-//
-// It's mostly copy-pasted from llvm sources.
-bool is_potentially_reachable_custom(llvm::BasicBlock const * source, llvm::BasicBlock const * dest,
-                                     llvm::BasicBlock const * checkpoint, llvm::DominatorTree const & DT)
-{
-    llvm::SmallVector<llvm::BasicBlock const *, 32> worklist;
-    worklist.push_back(source);
-
-    // When the stop block is unreachable, it's dominated from everywhere,
-    // regardless of whether there's a path between the two blocks.
-    if (!DT.isReachableFromEntry(dest))
-      return false;
-
-    // Limit the number of blocks we visit. The goal is to avoid run-away compile
-    // times on large CFGs without hampering sensible code. Arbitrarily chosen.
-    unsigned Limit = 32;
-    llvm::SmallPtrSet<llvm::BasicBlock const *, 32> visited;
-    do {
-      llvm::BasicBlock const * BB = worklist.pop_back_val();
-      if (!visited.insert(BB).second)
-        continue;
-      if (BB == dest)
-        return true;
-//      if (DT.dominates(BB, dest))
-//        return true;
-
-      if (!--Limit) {
-        // We haven't been able to prove it one way or the other. Conservatively
-        // answer true -- that there is potentially a path.
-        return true;
-      }
-
-      if (BB != checkpoint)
-        worklist.append(llvm::succ_begin(BB), llvm::succ_end(BB));
-
-    } while (!worklist.empty());
-
-    // We have exhausted all possible paths and are certain that 'To' can not be
-    // reached from 'From'.
-    return false;
-}
-
-analyzer_t::predicates_t analyzer_t::collect_predicates(llvm::BasicBlock const * bb)
+analyzer_t::predicates_t const & analyzer_t::collect_predicates(llvm::BasicBlock const * bb)
 {
+    static predicates_t const no_predicates;
     if (!bb)
-        return {};
+        return no_predicates;
 
     llvm::Function const * func = bb->getParent();
     if (!func)
-        return {};
+        return no_predicates;
+
+    // Predicates are cached per function:
+    // 1. Dominator tree is built once when we start querying blocks of a new function.
+    // 2. Block inherits predicates of its immediate dominator and adds ones
+    //    which come from the immediate dominator's terminator.
+    // 3. Reachability from successors of that terminator is looked up in the
+    //    function's reachability index.
+    if (pimpl().cached_function != func)
+        reset_function_cache(*func);
+
+    auto & cache = pimpl().block_predicates;
+    auto cached = cache.find(bb);
+    if (cached != cache.end())
+        return cached->second;
 
-    // Currently it works as follows:
-    // 1. Iterate through all blocks within function and collect dominators.
-    // 2. Iterate through all dominators and examine reachability from successors.
-    //
-    // Probably it can be optimized.
+    llvm::DominatorTree const & dom_tree = pimpl().ctx.dtwp.getDomTree();
 
-    pimpl().ctx.dtwp.runOnFunction(*const_cast<llvm::Function *>(func));
+    // Walk up the dominator tree until we find a block with known predicates,
+    // then compute predicates on the way down. It's done iteratively because
+    // dominator trees of generated code can be very deep.
+    std::vector<llvm::BasicBlock const *> chain;
+    llvm::DomTreeNode const * node = dom_tree.getNode(bb);
+    predicates_t const * inherited = &no_predicates;
+    while (node)
+    {
+        llvm::BasicBlock const * cur = node->getBlock();
+        auto it = cache.find(cur);
+        if (it != cache.end())
+        {
+            inherited = &it->second;
+            break;
+        }
 
-    llvm::DominatorTree const & dom_tree = pimpl().ctx.dtwp.getDomTree();
-    std::vector<llvm::BasicBlock const *> dominators;
-    for (auto const & another_bb : *func)
+        chain.push_back(cur);
+        node = node->getIDom();
+    }
+
+    if (chain.empty())
+        return cache.emplace(bb, no_predicates).first->second;
+
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it)
     {
-        if (dom_tree.properlyDominates(&another_bb, bb))
-            dominators.push_back(&another_bb);
+        llvm::BasicBlock const * cur = *it;
+        predicates_t predicates = *inherited;
+        if (llvm::DomTreeNode const * idom = dom_tree.getNode(cur)->getIDom())
+            collect_branch_predicates(idom->getBlock(), cur, predicates);
+
+        inherited = &cache.emplace(cur, std::move(predicates)).first->second;
     }
 
-    predicates_t predicates;
-    for (llvm::BasicBlock const * dominator : dominators)
+    return *inherited;
+}
+
+// Add predicates which hold in 'bb' because of the conditional branch or the
+// switch terminating its dominator 'dominator'.
+void analyzer_t::collect_branch_predicates(llvm::BasicBlock const * dominator, llvm::BasicBlock const * bb,
+                                           predicates_t & predicates)
+{
+    reachability_t const & reachability = *pimpl().reachability;
+    llvm::TerminatorInst const * terminator = dominator->getTerminator();
+    if (auto br = llvm::dyn_cast_or_null<llvm::BranchInst>(terminator))
     {
-        llvm::TerminatorInst const * terminator = dominator->getTerminator();
-        if (auto br = dynamic_cast<llvm::BranchInst const *>(terminator))
-        {
-            if (br->isUnconditional())
-                continue;
+        if (br->isUnconditional())
+            return;
+
+        llvm::BasicBlock const * true_bb = br->getSuccessor(0);
+        llvm::BasicBlock const * false_bb = br->getSuccessor(1);
+        bool reachable_from_true = reachability.is_reachable(true_bb, bb, dominator);
+        bool reachable_from_false = reachability.is_reachable(false_bb, bb, dominator);
+        bool is_true_succ;
+        if (reachable_from_false && !reachable_from_true)
+            is_true_succ = false;
+        else if (reachable_from_true && !reachable_from_false)
+            is_true_succ = true;
+        else
+            return;
 
-            llvm::BasicBlock const * true_bb = br->getSuccessor(0);
-            llvm::BasicBlock const * false_bb = br->getSuccessor(1);
-            bool reachable_from_true = is_potentially_reachable_custom(true_bb, bb, dominator, dom_tree);
-            bool reachable_from_false = is_potentially_reachable_custom(false_bb, bb, dominator, dom_tree);
-//            pimpl().debug_out << "dominator: " << *dominator->getTerminator()
-//                       << ", reachable from true: " << reachable_from_true
-//                       << ", reachable from false: " << reachable_from_false
-//                       << "\n";
-            bool is_true_succ;
-            if (reachable_from_false && !reachable_from_true)
-                is_true_succ = false;
-            else if (reachable_from_true && !reachable_from_false)
-                is_true_succ = true;
-            else
+        collect_cmp_predicates(br->getCondition(), is_true_succ, predicates);
+    }
+    else if (auto sw = llvm::dyn_cast_or_null<llvm::SwitchInst>(terminator))
+    {
+        // 'bb' must be reachable from a single successor
+        llvm::BasicBlock const * taken = nullptr;
+        for (unsigned i = 0; i != sw->getNumSuccessors(); ++i)
+        {
+            llvm::BasicBlock const * succ = sw->getSuccessor(i);
+            if (succ == taken || !reachability.is_reachable(succ, bb, dominator))
                 continue;
+            if (taken)
+                return;
 
-            if (auto cmp_inst = dynamic_cast<llvm::ICmpInst const *>(br->getCondition()))
-            {
-                auto add_pred = [&predicates, cmp_inst](bool swap_args, predicate_type pr_type)
-                {
-                    predicate_t pred = {pr_type,
-                                        swap_args ? cmp_inst->getOperand(1)
-                                                  : cmp_inst->getOperand(0),
-                                        swap_args ? cmp_inst->getOperand(0)
-                                                  : cmp_inst->getOperand(1),
-                                        cmp_inst};
-                    predicates.push_back(pred);
-                };
-
-                switch (cmp_inst->getPredicate())
-                {
-                case llvm::ICmpInst::ICMP_EQ:
-                    {
-                        auto pr_type = is_true_succ ? PT_EQ : PT_NE;
-                        add_pred(false, pr_type);
-                        break;
-                    }
-                case llvm::ICmpInst::ICMP_NE:
-                    {
-                        auto pr_type = is_true_succ ? PT_NE : PT_EQ;
-                        add_pred(false, pr_type);
-                        break;
-                    }
-                case llvm::ICmpInst::ICMP_UGT:
-                case llvm::ICmpInst::ICMP_SGT:
-                    {
-                        auto pr_type = is_true_succ ? PT_LT : PT_LE;
-                        bool swap_args = is_true_succ;
-                        add_pred(swap_args, pr_type);
-                        break;
-                    }
-                case llvm::ICmpInst::ICMP_UGE:
-                case llvm::ICmpInst::ICMP_SGE:
-                    {
-                        auto pr_type = is_true_succ ? PT_LE : PT_LT;
-                        bool swap_args = is_true_succ;
-                        add_pred(swap_args, pr_type);
-                        break;
-                    }
-                case llvm::ICmpInst::ICMP_ULT:
-                case llvm::ICmpInst::ICMP_SLT:
-                    {
-                        auto pr_type = is_true_succ ? PT_LT : PT_LE;
-                        bool swap_args = !is_true_succ;
-                        add_pred(swap_args, pr_type);
-                        break;
-                    }
-                case llvm::ICmpInst::ICMP_ULE:
-                case llvm::ICmpInst::ICMP_SLE:
-                    {
-                        auto pr_type = is_true_succ ? PT_LE : PT_LT;
-                        bool swap_args = !is_true_succ;
-                        add_pred(swap_args, pr_type);
-                        break;
-                    }
-                default:
-                    {
-                    }
-                }
-            }
+            taken = succ;
         }
-    }
 
-    return predicates;
+        if (taken)
+            collect_switch_predicates(*sw, taken, predicates);
+    }
 }
 
-analyzer_t::predicates_t analyzer_t::collect_gating_predicates(var_id v, gating_cond_t const & cond)
+// Add predicates which hold when 'cond' has value 'holds'.
+void analyzer_t::collect_cmp_predicates(llvm::Value const * cond, bool holds, predicates_t & predicates)
 {
-    predicates_t predicates;
-    auto to_predicates = [&](llvm::Value const * gating_cond)
+    auto cmp_inst = llvm::dyn_cast_or_null<llvm::ICmpInst>(cond);
+    if (!cmp_inst)
+        return;
+
+    auto add_pred = [&predicates, cmp_inst](bool swap_args, predicate_type pr_type)
     {
-        if (auto cmp_inst = dynamic_cast<llvm::ICmpInst const *>(gating_cond))
-        {
-            auto add_pred = [&predicates, cmp_inst](bool swap_args, predicate_type pr_type)
-            {
-                predicate_t pred = {pr_type,
-                                    swap_args ? cmp_inst->getOperand(1)
-                                              : cmp_inst->getOperand(0),
-                                    swap_args ? cmp_inst->getOperand(0)
-                                              : cmp_inst->getOperand(1),
-                                    cmp_inst};
-                predicates.push_back(pred);
-            };
-
-            switch (cmp_inst->getPredicate())
-            {
-            case llvm::ICmpInst::ICMP_EQ:
-                {
-                    add_pred(false, PT_EQ);
-                    break;
-                }
-            case llvm::ICmpInst::ICMP_NE:
-                {
-                    add_pred(false, PT_NE);
-                    break;
-                }
-            case llvm::ICmpInst::ICMP_UGT:
-            case llvm::ICmpInst::ICMP_SGT:
-                {
-                    add_pred(true, PT_LT);
-                    break;
-                }
-            case llvm::ICmpInst::ICMP_UGE:
-            case llvm::ICmpInst::ICMP_SGE:
-                {
-                    add_pred(true, PT_LE);
-                    break;
-                }
-            case llvm::ICmpInst::ICMP_ULT:
-            case llvm::ICmpInst::ICMP_SLT:
-                {
-                    add_pred(false, PT_LE);
-                    break;
-                }
-            case llvm::ICmpInst::ICMP_ULE:
-            case llvm::ICmpInst::ICMP_SLE:
-                {
-                    add_pred(false, PT_LT);
-                    break;
-                }
-            default:
-                {
-                }
-            }
-        }
+        predicate_t pred = {pr_type,
+                            swap_args ? cmp_inst->getOperand(1)
+                                      : cmp_inst->getOperand(0),
+                            swap_args ? cmp_inst->getOperand(0)
+                                      : cmp_inst->getOperand(1),
+                            cmp_inst};
+        predicates.push_back(pred);
     };
 
-    auto negate = [&](predicate_t & pred)
+    switch (cmp_inst->getPredicate())
     {
-        switch (pred.type)
+    case llvm::ICmpInst::ICMP_EQ:
+        {
+            auto pr_type = holds ? PT_EQ : PT_NE;
+            add_pred(false, pr_type);
+            break;
+        }
+    case llvm::ICmpInst::ICMP_NE:
         {
-        case PT_EQ:
+            auto pr_type = holds ? PT_NE : PT_EQ;
+            add_pred(false, pr_type);
+            break;
+        }
+    case llvm::ICmpInst::ICMP_UGT:
+    case llvm::ICmpInst::ICMP_SGT:
         {
-            pred.type = PT_NE;
+            auto pr_type = holds ? PT_LT : PT_LE;
+            bool swap_args = holds;
+            add_pred(swap_args, pr_type);
             break;
         }
-        case PT_NE:
+    case llvm::ICmpInst::ICMP_UGE:
+    case llvm::ICmpInst::ICMP_SGE:
         {
-            pred.type = PT_EQ;
+            auto pr_type = holds ? PT_LE : PT_LT;
+            bool swap_args = holds;
+            add_pred(swap_args, pr_type);
             break;
         }
-        case PT_LT:
+    case llvm::ICmpInst::ICMP_ULT:
+    case llvm::ICmpInst::ICMP_SLT:
         {
-            pred.type = PT_LE;
-            std::swap(pred.lhs, pred.rhs);
+            auto pr_type = holds ? PT_LT : PT_LE;
+            bool swap_args = !holds;
+            add_pred(swap_args, pr_type);
             break;
         }
-        case PT_LE:
+    case llvm::ICmpInst::ICMP_ULE:
+    case llvm::ICmpInst::ICMP_SLE:
         {
-            pred.type = PT_LT;
-            std::swap(pred.lhs, pred.rhs);
+            auto pr_type = holds ? PT_LE : PT_LT;
+            bool swap_args = !holds;
+            add_pred(swap_args, pr_type);
             break;
         }
+    default:
+        {
         }
-    };
+    }
+}
+
+// Add predicates which hold when 'sw' goes to 'successor': the condition is
+// equal to the only case going there or lies between the smallest and the
+// biggest of such cases. For the default destination it differs from other
+// cases, but these inequalities only refine bounds equal to a case value, so
+// they are skipped for big switches.
+void analyzer_t::collect_switch_predicates(llvm::SwitchInst const & sw, llvm::BasicBlock const * successor,
+                                           predicates_t & predicates)
+{
+    static unsigned const max_inequalities = 16;
+    var_id cond = sw.getCondition();
+    if (sw.getDefaultDest() == successor)
+    {
+        if (sw.getNumCases() > max_inequalities)
+            return;
+
+        for (auto const & c : sw.cases())
+        {
+            if (c.getCaseSuccessor() != successor)
+                predicates.push_back({PT_NE, cond, c.getCaseValue(), &sw});
+        }
+
+        return;
+    }
 
-    if (auto simple_cond = dynamic_cast<simple_gating_cond_t const *>(&cond))
+    llvm::ConstantInt const * min = nullptr;
+    llvm::ConstantInt const * max = nullptr;
+    for (auto const & c : sw.cases())
     {
-        to_predicates(simple_cond->predicate);
+        if (c.getCaseSuccessor() != successor)
+            continue;
+
+        llvm::ConstantInt const * value = c.getCaseValue();
+        if (!min || value->getValue().slt(min->getValue()))
+            min = value;
+        if (!max || value->getValue().sgt(max->getValue()))
+            max = value;
     }
-    else if (auto neg_cond = dynamic_cast<negated_gating_cond_t const *>(&cond))
+
+    if (!min)
+        return;
+
+    if (min == max)
     {
-        to_predicates(neg_cond->predicate);
-        for (auto & pred : predicates)
-            negate(pred);
+        predicates.push_back({PT_EQ, cond, min, &sw});
     }
-    else if (auto conj_cond = dynamic_cast<conjuncted_gating_cond_t const *>(&cond))
+    else
     {
-        predicates_t preds1 = collect_gating_predicates(v, *(conj_cond->lhs));
-        predicates_t preds2 = collect_gating_predicates(v, *(conj_cond->rhs));
-        std::copy(preds2.begin(), preds2.end(), std::back_inserter(preds1));
-        return preds1;
+        predicates.push_back({PT_LE, min, cond, &sw});
+        predicates.push_back({PT_LE, cond, max, &sw});
     }
+}
 
-    return predicates;
+void analyzer_t::reset_function_cache(llvm::Function const & func)
+{
+    pimpl().cached_function = &func;
+    pimpl().block_predicates.clear();
+    pimpl().ctx.dtwp.runOnFunction(*const_cast<llvm::Function *>(&func));
+    pimpl().reachability.reset(new reachability_t(func, pimpl().ctx.dtwp.getDomTree()));
+}
+
+analyzer_t::predicates_t const & analyzer_t::collect_gating_predicates(gating_cond_t const & cond)
+{
+    auto & cache = pimpl().gating_predicates;
+    auto cached = cache.find(&cond);
+    if (cached != cache.end())
+        return cached->second;
+
+    predicates_t predicates;
+    gating_literal_t const & literal = cond.literal();
+    if (auto sw = llvm::dyn_cast<llvm::SwitchInst>(literal.predicate))
+        collect_switch_predicates(*sw, literal.successor, predicates);
+    else
+        collect_cmp_predicates(literal.predicate, !literal.negated, predicates);
+
+    return cache.emplace(&cond, std::move(predicates)).first->second;
 }
 
 sym_range analyzer_t::refine_def_range(var_id v, sym_range def_range, program_point_t p)
@@ -303,18 +282,24 @@ sym_range analyzer_t::refine_def_range(var_id v, sym_range def_range, program_po
         return def_range;
 
     llvm::BasicBlock const * bb = p->getParent();
-    predicates_t predicates = collect_predicates(bb);
-    for (predicate_t const & predicate : predicates)
+    for (predicate_t const & predicate : collect_predicates(bb))
         def_range = refine_def_range_internal(v, def_range, predicate);
 
     return def_range;
 }
 
+// Literals are applied from the first one, the top of the region.
 sym_range analyzer_t::refine_def_range_gating(var_id v, sym_range def_range, gating_cond_t const & cond)
 {
-    predicates_t predicates = collect_gating_predicates(v, cond);
-    for (predicate_t const & predicate : predicates)
-        def_range = refine_def_range_internal(v, def_range, predicate);
+    llvm::SmallVector<gating_cond_t const *, 8> nodes;
+    for (gating_cond_t const * node = &cond; node; node = node->parent())
+        nodes.push_back(node);
+
+    for (auto it = nodes.rbegin(); it != nodes.rend(); ++it)
+    {
+        for (predicate_t const & predicate : collect_gating_predicates(**it))
+            def_range = refine_def_range_internal(v, def_range, predicate);
+    }
 
     return def_range;
 }
@@ -332,7 +317,7 @@ boost::optional<match_res_t> match_var(var_id v, var_id to_match_with)
     if (v == to_match_with)
         return match_res_t({1, 0});
 
-    if (auto bin_op = dynamic_cast<llvm::BinaryOperator const *>(to_match_with))
+    if (auto bin_op = llvm::dyn_cast_or_null<llvm::BinaryOperator>(to_match_with))
     {
         var_id op0 = bin_op->getOperand(0), op1 = bin_op->getOperand(1);
         if (op0 != v && op1 != v)
@@ -357,7 +342,7 @@ boost::optional<match_res_t> match_var(var_id v, var_id to_match_with)
         }
     }
 
-    if (auto bin_op = dynamic_cast<llvm::BinaryOperator const *>(v))
+    if (auto bin_op = llvm::dyn_cast_or_null<llvm::BinaryOperator>(v))
     {
         var_id op0 = bin_op->getOperand(0), op1 = bin_op->getOperand(1);
         if (op0 != to_match_with && op1 != to_match_with)
@@ -387,14 +372,14 @@ boost::optional<match_res_t> match_var(var_id v, var_id to_match_with)
 sym_range analyzer_t::refine_def_range_internal(var_id v, sym_range const & def_range,
                                                 analyzer_t::predicate_t const & pred)
 {
-    if (pred.type == PT_NE)
+    if (pred.type == PT_NE && pimpl().options.refine_phi_induction)
     {
         // suppose we have a predicate that x != y
         // suppose that x = \phi(a, f(x))
         // suppose that f(a) = a + t where `t` has a constant sign
         // suppose that there exists such `c` that `y = a + c * t`
         // in this case we know that `x < y` (or `>` depending on sign of `t`)
-        if (auto phi_v = dynamic_cast<llvm::PHINode const *>(v))
+        if (auto phi_v = llvm::dyn_cast_or_null<llvm::PHINode>(v))
         {
             var_id y = nullptr;
             if (pred.lhs == v)
@@ -407,7 +392,7 @@ sym_range analyzer_t::refine_def_range_internal(var_id v, sym_range const & def_
                 var_id a = phi_v->getIncomingValue(0);
                 var_id inc_v1 = phi_v->getIncomingValue(1);
 
-                if (auto f = dynamic_cast<llvm::BinaryOperator const *>(inc_v1))
+                if (auto f = llvm::dyn_cast_or_null<llvm::BinaryOperator>(inc_v1))
                 {
                     if (f->getOpcode() == llvm::BinaryOperator::Add)
                     {
@@ -12,14 +12,15 @@
 void analyzer_t::report_overflow(llvm::Instruction const & instr,
                                  boost::optional<sym_range const &> idx_range,
                                  boost::optional<sym_range const &> size_range,
-                                 bool sure)
+                                 bool sure,
+                                 bool budget_exhausted)
 {
     if (sure)
         ++pimpl().total_overflows;
     else
         ++pimpl().total_indeterminate;
 
-    if (!pimpl().report_indeterminate && !sure)
+    if (!pimpl().options.report_indeterminate && !sure)
         return;
 
     instr.getDebugLoc().print(pimpl().res_out);
@@ -34,7 +35,9 @@ void analyzer_t::report_overflow(llvm::Instruction const & instr,
     };
 
     pimpl().res_out << " | overflow "
-             << (sure ? "is possible" : "may be possible (but not surely)")
+             << (sure ? "is possible"
+                 : budget_exhausted ? "may be possible (analysis budget exhausted)"
+                 : "may be possible (but not surely)")
              << " in function "
              << func_name
              << ", instruction { "
@@ -53,3 +56,8 @@ void analyzer_t::report_potential_overflow(llvm::Instruction const & instr,
 {
     report_overflow(instr, idx_range, size_range, false);
 }
+
+void analyzer_t::report_budget_exhausted(llvm::Instruction const & instr)
+{
+    report_overflow(instr, boost::none, boost::none, false, true);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Find strongly connected components of a graph with vertices '0 … n-1'
+// using iterative version of Tarjan's algorithm, so that deep graphs don't
+// overflow the stack. 'succs(v)' must return a range of successors of 'v'.
+//
+// Returns component number of every vertex. Components are numbered in
+// reverse topological order: successors of a component have smaller numbers.
+template <class Succs>
+std::vector<unsigned> find_sccs(unsigned n, Succs const & succs, unsigned & scc_count)
+{
+    unsigned const unvisited = std::numeric_limits<unsigned>::max();
+    std::vector<unsigned> index(n, unvisited), low(n), scc(n, 0);
+    std::vector<bool> on_stack(n, false);
+    std::vector<unsigned> stack;
+    std::vector<std::pair<unsigned, size_t>> call_stack;
+    unsigned counter = 0;
+    scc_count = 0;
+
+    for (unsigned root = 0; root != n; ++root)
+    {
+        if (index[root] != unvisited)
+            continue;
+
+        call_stack.emplace_back(root, 0);
+        while (!call_stack.empty())
+        {
+            unsigned v = call_stack.back().first;
+            size_t & next = call_stack.back().second;
+            if (next == 0 && index[v] == unvisited)
+            {
+                index[v] = low[v] = counter++;
+                stack.push_back(v);
+                on_stack[v] = true;
+            }
+
+            auto const & v_succs = succs(v);
+            if (next < v_succs.size())
+            {
+                unsigned w = v_succs[next++];
+                if (index[w] == unvisited)
+                    call_stack.emplace_back(w, 0);
+                else if (on_stack[w])
+                    low[v] = std::min(low[v], index[w]);
+
+                continue;
+            }
+
+            if (low[v] == index[v])
+            {
+                unsigned w;
+                do
+                {
+                    w = stack.back();
+                    stack.pop_back();
+                    on_stack[w] = false;
+                    scc[w] = scc_count;
+                } while (w != v);
+
+                ++scc_count;
+            }
+
+            call_stack.pop_back();
+            if (!call_stack.empty())
+            {
+                unsigned parent = call_stack.back().first;
+                low[parent] = std::min(low[parent], low[v]);
+            }
+        }
+    }
+
+    return scc;
+}
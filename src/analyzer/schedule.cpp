@@ -0,0 +1,170 @@
+#include "schedule.h"
+#include "scc.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace
+{
+
+struct work_queue_t
+{
+    std::mutex mutex;
+    std::deque<unsigned> components;
+};
+
+}
+
+void schedule_functions(func_vector const & functions, unsigned jobs,
+                        std::function<void(unsigned, llvm::Function const *)> const & process)
+{
+    unsigned const n = functions.size();
+    std::unordered_map<llvm::Function const *, unsigned> numbers;
+    for (unsigned i = 0; i != n; ++i)
+        numbers.emplace(functions[i], i);
+
+    std::vector<std::vector<unsigned>> callees(n);
+    for (unsigned i = 0; i != n; ++i)
+    {
+        for (llvm::Function const * called : get_called_functions(functions[i]))
+        {
+            auto it = numbers.find(called);
+            if (it != numbers.end())
+                callees[i].push_back(it->second);
+        }
+    }
+
+    unsigned scc_count;
+    std::vector<unsigned> scc = find_sccs(n, [&callees](unsigned v) -> std::vector<unsigned> const & { return callees[v]; }, scc_count);
+
+    // Build DAG of components. Functions of a component keep the given order.
+    std::vector<std::vector<unsigned>> members(scc_count), callers(scc_count);
+    std::unique_ptr<std::atomic<unsigned>[]> pending(new std::atomic<unsigned>[scc_count]);
+    for (unsigned c = 0; c != scc_count; ++c)
+        pending[c] = 0;
+
+    for (unsigned i = 0; i != n; ++i)
+        members[scc[i]].push_back(i);
+
+    for (unsigned c = 0; c != scc_count; ++c)
+    {
+        std::vector<bool> seen(scc_count, false);
+        for (unsigned i : members[c])
+        {
+            for (unsigned callee : callees[i])
+            {
+                unsigned callee_c = scc[callee];
+                if (callee_c == c || seen[callee_c])
+                    continue;
+
+                seen[callee_c] = true;
+                callers[callee_c].push_back(c);
+                ++pending[c];
+            }
+        }
+    }
+
+    jobs = std::max(1u, jobs);
+    std::vector<work_queue_t> queues(jobs);
+    std::mutex sleep_mutex;
+    std::condition_variable wake_up;
+    unsigned available = 0, finished = 0;
+
+    auto push = [&](unsigned worker, unsigned c)
+    {
+        {
+            std::lock_guard<std::mutex> lock(queues[worker].mutex);
+            queues[worker].components.push_back(c);
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            ++available;
+        }
+        wake_up.notify_one();
+    };
+
+    auto take = [&](unsigned worker, unsigned & c)
+    {
+        bool found = false;
+        for (unsigned k = 0; k != jobs && !found; ++k)
+        {
+            work_queue_t & queue = queues[(worker + k) % jobs];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.components.empty())
+                continue;
+
+            if (k == 0)
+            {
+                c = queue.components.back();
+                queue.components.pop_back();
+            }
+            else
+            {
+                c = queue.components.front();
+                queue.components.pop_front();
+            }
+
+            found = true;
+        }
+
+        if (found)
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            --available;
+        }
+
+        return found;
+    };
+
+    for (unsigned c = 0; c != scc_count; ++c)
+    {
+        if (!pending[c])
+        {
+            queues[c % jobs].components.push_back(c);
+            ++available;
+        }
+    }
+
+    auto worker = [&](unsigned w)
+    {
+        for (;;)
+        {
+            unsigned c;
+            if (!take(w, c))
+            {
+                std::unique_lock<std::mutex> lock(sleep_mutex);
+                wake_up.wait(lock, [&]() { return available > 0 || finished == scc_count; });
+                if (finished == scc_count)
+                    return;
+
+                continue;
+            }
+
+            for (unsigned i : members[c])
+                process(w, functions[i]);
+
+            for (unsigned caller : callers[c])
+            {
+                if (--pending[caller] == 0)
+                    push(w, caller);
+            }
+
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            if (++finished == scc_count)
+                wake_up.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned w = 1; w < jobs; ++w)
+        threads.emplace_back(worker, w);
+
+    worker(0);
+    for (auto & t : threads)
+        t.join();
+}
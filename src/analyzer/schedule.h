@@ -0,0 +1,21 @@
+#pragma once
+
+#include <functional>
+
+#include "analyzer/sort.h"
+
+// Process functions on a pool of 'jobs' worker threads.
+//
+// Functions are grouped into strongly connected components of the call graph.
+// A component becomes ready once all components it calls are processed, and
+// all its functions are processed by one worker in the order they are given
+// (so it should be the order produced by 'sort_functions').
+//
+// Every worker has its own queue of ready components. Worker takes the most
+// recently added component from its queue and steals the oldest one from
+// another queue when its own is empty. Components unblocked by a worker are
+// added to its queue.
+//
+// 'process' is called with the number of worker ('0 … jobs-1') and a function.
+void schedule_functions(func_vector const &, unsigned jobs,
+                        std::function<void(unsigned, llvm::Function const *)> const & process);
@@ -0,0 +1,184 @@
+#include "slice.h"
+
+#include <llvm/ADT/DenseSet.h>
+#include <llvm/IR/GlobalVariable.h>
+
+llvm::GetElementPtrInst const * constant_table_access(llvm::LoadInst const & load,
+                                                      llvm::ConstantDataSequential const * & table)
+{
+    auto gep = llvm::dyn_cast_or_null<llvm::GetElementPtrInst>(load.getPointerOperand());
+    if (!gep || gep->getNumIndices() != 2)  // TODO: check that 0-th index is 0
+        return nullptr;
+
+    table = llvm::dyn_cast_or_null<llvm::ConstantDataSequential>(gep->getPointerOperand());
+    if (!table)
+    {
+        if (auto gv = llvm::dyn_cast_or_null<llvm::GlobalVariable>(gep->getPointerOperand()))
+        {
+            if (gv->isConstant())
+                table = llvm::dyn_cast_or_null<llvm::ConstantDataSequential>(gv->getInitializer());
+        }
+    }
+
+    return table ? gep : nullptr;
+}
+
+void def_range_operands(llvm::Value const & v, std::vector<var_id> & operands)
+{
+    auto instr = llvm::dyn_cast<llvm::Instruction>(&v);
+    if (!instr)
+        return;
+
+    if (llvm::isa<llvm::BinaryOperator>(instr))
+    {
+        operands.push_back(instr->getOperand(0));
+        operands.push_back(instr->getOperand(1));
+        return;
+    }
+
+    switch (instr->getOpcode())
+    {
+    case llvm::Instruction::PHI:
+        for (var_id inc_v : llvm::cast<llvm::PHINode>(instr)->incoming_values())
+            operands.push_back(inc_v);
+        break;
+    case llvm::Instruction::Load:
+    {
+        llvm::ConstantDataSequential const * table = nullptr;
+        if (auto gep = constant_table_access(*llvm::cast<llvm::LoadInst>(instr), table))
+            operands.push_back(*std::next(gep->idx_begin()));
+        break;
+    }
+    case llvm::Instruction::SExt:
+    case llvm::Instruction::ZExt:
+        operands.push_back(instr->getOperand(0));
+        break;
+    case llvm::Instruction::Select:
+        if (instr->getType()->isIntegerTy())
+        {
+            operands.push_back(llvm::cast<llvm::SelectInst>(instr)->getTrueValue());
+            operands.push_back(llvm::cast<llvm::SelectInst>(instr)->getFalseValue());
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+namespace
+{
+
+// Values which size of the buffer pointed to by 'ptr' is computed from.
+// Mirrors 'analyzer_t::compute_buffer_size_range'.
+void buffer_size_operands(var_id ptr, std::vector<var_id> & operands)
+{
+    while (auto instr = llvm::dyn_cast_or_null<llvm::Instruction>(ptr))
+    {
+        switch (instr->getOpcode())
+        {
+        case llvm::Instruction::Alloca:
+            operands.push_back(llvm::cast<llvm::AllocaInst>(instr)->getArraySize());
+            return;
+        case llvm::Instruction::Call:
+            // only allocation functions matter, but checking for them here
+            // isn't worth it
+        {
+            auto call = llvm::cast<llvm::CallInst>(instr);
+            if (call->getNumArgOperands())
+                operands.push_back(call->getArgOperand(0));
+            return;
+        }
+        case llvm::Instruction::BitCast:
+            ptr = instr->getOperand(0);
+            break;
+        default:
+            return;
+        }
+    }
+}
+
+}
+
+std::vector<var_id> compute_access_slice(llvm::Function const & func)
+{
+    std::vector<var_id> slice;
+    llvm::DenseSet<var_id> in_slice;
+    auto add = [&](var_id v)
+    {
+        if ((llvm::isa<llvm::Instruction>(v) || llvm::isa<llvm::Argument>(v))
+                && in_slice.insert(v).second)
+            slice.push_back(v);
+    };
+
+    auto add_compared = [&](var_id user)
+    {
+        if (auto cmp = llvm::dyn_cast<llvm::ICmpInst>(user))
+        {
+            add(cmp->getOperand(0));
+            add(cmp->getOperand(1));
+        }
+    };
+
+    std::vector<var_id> operands;
+    for (auto const & bb : func)
+    {
+        for (auto const & instr : bb)
+        {
+            var_id ptr = nullptr;
+            switch (instr.getOpcode())
+            {
+            case llvm::Instruction::Load:
+                ptr = llvm::cast<llvm::LoadInst>(instr).getPointerOperand();
+                break;
+            case llvm::Instruction::Store:
+                ptr = llvm::cast<llvm::StoreInst>(instr).getPointerOperand();
+                break;
+            case llvm::Instruction::Call:
+            {
+                // arguments may be substituted into triggers of the callee
+                auto & call = llvm::cast<llvm::CallInst>(instr);
+                for (unsigned i = 0; i != call.getNumArgOperands(); ++i)
+                    add(call.getArgOperand(i));
+                break;
+            }
+            default:
+                break;
+            }
+
+            if (auto gep = llvm::dyn_cast_or_null<llvm::GetElementPtrInst>(ptr))
+            {
+                add(*gep->idx_begin());
+                operands.clear();
+                buffer_size_operands(gep->getPointerOperand(), operands);
+                for (var_id op : operands)
+                    add(op);
+            }
+        }
+    }
+
+    // 'slice' grows while it's traversed.
+    for (size_t i = 0; i != slice.size(); ++i)
+    {
+        var_id v = slice[i];
+        operands.clear();
+        def_range_operands(*v, operands);
+        for (var_id op : operands)
+            add(op);
+
+        // Predicates refine the value if it's compared directly or with a
+        // constant added, subtracted or multiplied, see 'match_var'.
+        for (var_id user : v->users())
+        {
+            add_compared(user);
+            auto bin_op = llvm::dyn_cast<llvm::BinaryOperator>(user);
+            if (bin_op && (llvm::isa<llvm::Constant>(bin_op->getOperand(0))
+                           || llvm::isa<llvm::Constant>(bin_op->getOperand(1))))
+            {
+                for (var_id bin_op_user : bin_op->users())
+                    add_compared(bin_op_user);
+            }
+        }
+    }
+
+    return slice;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "common.h"
+
+#include <vector>
+
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Instructions.h>
+
+// If 'load' reads an element of a constant table using GEP with two indices,
+// returns that GEP and sets 'table'.
+llvm::GetElementPtrInst const * constant_table_access(llvm::LoadInst const & load,
+                                                      llvm::ConstantDataSequential const * & table);
+
+// Values whose define ranges are used to compute define range of 'v'.
+void def_range_operands(llvm::Value const & v, std::vector<var_id> & operands);
+
+// Backward slice of memory accesses of the function: arguments and
+// instructions whose ranges can be requested while checking GEP indices,
+// buffer sizes and arguments of calls. Besides operands, it includes values
+// compared with values of the slice, because predicates on them are used to
+// refine ranges. Ranges of other instructions are never computed.
+std::vector<var_id> compute_access_slice(llvm::Function const &);
@@ -7,8 +7,6 @@
 
 using f_ptr = llvm::Function const *;
 
-namespace {
-
 std::unordered_set<f_ptr> get_called_functions(f_ptr func)
 {
     std::unordered_set<f_ptr> res;
@@ -16,9 +14,10 @@ std::unordered_set<f_ptr> get_called_functions(f_ptr func)
     {
         for (auto const & instr : bb)
         {
-            if (auto call = dynamic_cast<llvm::CallInst const *>(&instr))
+            if (auto call = llvm::dyn_cast<llvm::CallInst>(&instr))
             {
-                res.insert(call->getCalledFunction());
+                if (f_ptr called = call->getCalledFunction())
+                    res.insert(called);
             }
         }
     }
@@ -26,8 +25,6 @@ std::unordered_set<f_ptr> get_called_functions(f_ptr func)
     return res;
 }
 
-}
-
 std::vector<f_ptr> sort_functions(std::vector<f_ptr> const & functions)
 {
     std::vector<f_ptr> res;
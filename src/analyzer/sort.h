@@ -1,11 +1,16 @@
 #pragma once
 
+#include <unordered_set>
 #include <vector>
 
 #include <llvm/IR/Function.h>
 
 using func_vector = std::vector<llvm::Function const *>;
 
+// Functions directly called from the given one.
+// Indirect calls are ignored.
+std::unordered_set<llvm::Function const *> get_called_functions(llvm::Function const *);
+
 // Sort functions in topological order.
 // Callee goes before caller.
 func_vector sort_functions(func_vector const &);
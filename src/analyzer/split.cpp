@@ -1,7 +1,12 @@
 #include "analyzer/impl.h"
+#include "analyzer/schedule.h"
 #include "analyzer/sort.h"
 
-#include <iostream>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <boost/logic/tribool.hpp>
 #include <boost/filesystem.hpp>
@@ -13,16 +18,16 @@
 
 namespace fs = boost::filesystem;
 
-void analyzer_t::analyze_file(fs::path const & p)
+bool analyzer_t::analyze_file(fs::path const & p)
 {
     llvm::LLVMContext context;
     llvm::SMDiagnostic error;
     auto m = llvm::parseIRFile(p.string(), error, context);
     if (!m)
     {
-        std::cerr << "Failed to parse module " << p.string() << std::endl;
-        error.print(p.string().c_str(), llvm::errs());
-        return;
+        pimpl().warn_out << "Failed to parse module " << p.string() << "\n";
+        error.print(p.string().c_str(), pimpl().warn_out);
+        return false;
     }
 
     analyze_module(*m);
@@ -30,6 +35,13 @@ void analyzer_t::analyze_file(fs::path const & p)
              << ", total number of indeterminate cases: " << pimpl().total_indeterminate
              << ", total number of correct memory usages: " << pimpl().total_correct
              << "\n";
+
+    return true;
+}
+
+analyzer_t::totals_t analyzer_t::totals() const
+{
+    return { pimpl().total_overflows, pimpl().total_indeterminate, pimpl().total_correct };
 }
 
 void analyzer_t::analyze_module(llvm::Module const & module)
@@ -40,7 +52,11 @@ void analyzer_t::analyze_module(llvm::Module const & module)
                << module.getSourceFileName()
                << "\n";
 
-    pimpl().gsa_builder.build(module);
+    if (pimpl().options.lazy_gsa)
+        pimpl().gsa_builder->reset(module);
+    else
+        pimpl().gsa_builder->build(module, pimpl().options.jobs);
+
     std::vector<const llvm::Function *> functions;
     for (auto const & f : module)
     {
@@ -51,18 +67,202 @@ void analyzer_t::analyze_module(llvm::Module const & module)
 
     auto sorted = sort_functions(functions);
 
-    for (auto f : sorted)
+    // Symbolic atoms created during analysis of the module are allocated in
+    // its own arena and are freed all at once when analysis is finished.
+    pimpl().arena = std::make_shared<atom_arena_t>();
+    atom_limits_t limits;
+    limits.max_size = pimpl().options.max_expr_size;
+    limits.max_depth = pimpl().options.max_expr_depth;
+    pimpl().arena->set_limits(limits);
+    {
+        atom_arena_scope_t arena_scope(*pimpl().arena);
+        if (pimpl().options.jobs > 1)
+        {
+            analyze_functions_parallel(sorted);
+        }
+        else
+        {
+            for (auto f : sorted)
+            {
+                analyze_function(*f);
+            }
+        }
+    }
+
+    pimpl().debug_out << "Use range cache: " << pimpl().use_range_hits << " hits, "
+                      << pimpl().use_range_misses << " misses\n";
+    pimpl().debug_out << "Accesses decided by prefilter: " << pimpl().prefilter_decided
+                      << ", by symbolic analysis: " << pimpl().symbolic_decided << "\n";
+    pimpl().use_range_hits = 0;
+    pimpl().use_range_misses = 0;
+    pimpl().prefilter_decided = 0;
+    pimpl().symbolic_decided = 0;
+    pimpl().debug_out << "Expressions over size limits: " << pimpl().arena->capped() << "\n";
+    pimpl().debug_out << "Functions over budget: " << pimpl().functions_over_budget << "\n";
+    pimpl().debug_out << "Functions with GSA form built: " << pimpl().gsa_builder->built_functions()
+                      << " of " << sorted.size() << "\n";
+    pimpl().functions_over_budget = 0;
+
+    clear_module_state();
+}
+
+// Drop everything which refers to the module or to its symbolic atoms.
+void analyzer_t::clear_module_state()
+{
+    pimpl().ctx.set_function(nullptr);
+    pimpl().ctx.def_ranges.clear();
+    pimpl().ctx.new_val_set.clear();
+    pimpl().ctx.vulnerability_info.clear();
+    pimpl().ctx.table_indices.clear();
+    pimpl().ctx.triggers = std::make_shared<trigger_map_t>();
+    pimpl().gsa_builder->clear();
+    pimpl().cached_function = nullptr;
+    pimpl().block_predicates.clear();
+    pimpl().gating_predicates.clear();
+    pimpl().reachability.reset();
+    pimpl().prefilter.reset();
+    pimpl().prefiltered.reset();
+    pimpl().arena.reset();
+}
+
+// Functions are analyzed by worker analyzers which have their own caches, but
+// share GSA and triggers. Output of every function is buffered and printed in
+// the given order, so it's the same as if functions were analyzed serially.
+void analyzer_t::analyze_functions_parallel(std::vector<llvm::Function const *> const & sorted)
+{
+    struct output_t
+    {
+        std::string res, warn, debug;
+    };
+
+    struct worker_t
+    {
+        output_t output;
+        llvm::raw_string_ostream res_out, warn_out, debug_out;
+        // 'llvm::nulls()' is buffered, so it can't be shared between threads
+        llvm::raw_null_ostream null_out;
+        std::unique_ptr<analyzer_t> analyzer;
+
+        worker_t()
+            : res_out(output.res)
+            , warn_out(output.warn)
+            , debug_out(output.debug)
+        {
+        }
+    };
+
+    std::unordered_map<llvm::Function const *, size_t> positions;
+    for (size_t i = 0; i != sorted.size(); ++i)
+        positions.emplace(sorted[i], i);
+
+    // Streams which are the same for this analyzer share one buffer in
+    // workers, so that their output is interleaved in the same way.
+    llvm::raw_ostream * res_out = &pimpl().res_out;
+    llvm::raw_ostream * warn_out = &pimpl().warn_out;
+    llvm::raw_ostream * debug_out = &pimpl().debug_out;
+    if (pimpl().options.prefilter)
+    {
+        using safe_set_t = std::unordered_set<llvm::GetElementPtrInst const *>;
+        pimpl().prefiltered = std::make_shared<safe_set_t const>(prefilter_functions(sorted));
+    }
+
+    unsigned jobs = pimpl().options.jobs;
+    std::vector<std::unique_ptr<worker_t>> workers;
+    for (unsigned i = 0; i != jobs; ++i)
     {
-        analyze_function(*f);
+        workers.emplace_back(new worker_t);
+        worker_t & w = *workers.back();
+        llvm::raw_ostream & w_warn = warn_out == res_out ? w.res_out : w.warn_out;
+        llvm::raw_ostream & w_debug = debug_out == &llvm::nulls() ? w.null_out
+                                    : debug_out == res_out ? w.res_out
+                                    : debug_out == warn_out ? w_warn
+                                    : w.debug_out;
+        w.analyzer.reset(new analyzer_t(*this, w.res_out, w_warn, w_debug));
+    }
+
+    std::vector<output_t> outputs(sorted.size());
+    schedule_functions(sorted, jobs, [&](unsigned worker, llvm::Function const * f)
+    {
+        worker_t & w = *workers[worker];
+        atom_arena_scope_t arena_scope(*pimpl().arena);
+        w.analyzer->analyze_function(*f);
+        w.res_out.flush();
+        w.warn_out.flush();
+        w.debug_out.flush();
+        std::swap(outputs[positions.at(f)], w.output);
+    });
+
+    for (output_t const & output : outputs)
+    {
+        pimpl().debug_out << output.debug;
+        pimpl().warn_out << output.warn;
+        pimpl().res_out << output.res;
+    }
+
+    for (auto const & w : workers)
+    {
+        totals_t worker_totals = w->analyzer->totals();
+        pimpl().total_overflows += worker_totals.overflows;
+        pimpl().total_indeterminate += worker_totals.indeterminate;
+        pimpl().total_correct += worker_totals.correct;
+        pimpl().use_range_hits += w->analyzer->pimpl().use_range_hits;
+        pimpl().use_range_misses += w->analyzer->pimpl().use_range_misses;
+        pimpl().prefilter_decided += w->analyzer->pimpl().prefilter_decided;
+        pimpl().symbolic_decided += w->analyzer->pimpl().symbolic_decided;
+        pimpl().functions_over_budget += w->analyzer->pimpl().functions_over_budget;
     }
 }
 
 void analyzer_t::analyze_function(llvm::Function const & f)
 {
     pimpl().debug_out << "Analyzing function " << f.getName() << "\n";
+    pimpl().ctx.set_function(&f);
+    pimpl().debug_out << "Values in access slice: " << pimpl().ctx.numbering.size() << "\n";
+
+    if (pimpl().options.prefilter && !pimpl().prefiltered)
+        pimpl().prefilter.reset(new prefilter_t(f));
 
+    // Time spent on the slice and the prefilter isn't counted.
+    analyzer_options_t const & options = pimpl().options;
+    pimpl().function_deadline = options.deadline;
+    if (options.function_time_limit_ms)
+    {
+        auto limit = std::chrono::steady_clock::now()
+                   + std::chrono::milliseconds(options.function_time_limit_ms);
+        if (!options.deadline || limit < *options.deadline)
+            pimpl().function_deadline = limit;
+    }
+
+    pimpl().def_range_calls = 0;
+    pimpl().budget_checks = 0;
+    pimpl().budget_exhausted = false;
     for (auto const & bb : f)
         analyze_basic_block(bb);
+
+    if (pimpl().budget_exhausted)
+    {
+        pimpl().debug_out << "Budget of function " << f.getName() << " exhausted after "
+                          << pimpl().def_range_calls << " define range computations\n";
+        ++pimpl().functions_over_budget;
+    }
+}
+
+bool analyzer_t::out_of_budget(bool read_clock)
+{
+    if (pimpl().budget_exhausted)
+        return true;
+
+    // Reading the clock is much more expensive than a cached define range,
+    // so time is checked only once in a while. Checks are counted instead
+    // of define ranges, as GSA and predicates are built between them too.
+    size_t const checks = ++pimpl().budget_checks;
+    unsigned const limit = pimpl().options.function_def_range_limit;
+    if (limit && pimpl().def_range_calls > limit)
+        pimpl().budget_exhausted = true;
+    else if (pimpl().function_deadline && (read_clock || checks % 256 == 0))
+        pimpl().budget_exhausted = std::chrono::steady_clock::now() >= *pimpl().function_deadline;
+
+    return pimpl().budget_exhausted;
 }
 
 void analyzer_t::analyze_basic_block(llvm::BasicBlock const & bb)
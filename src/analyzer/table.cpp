@@ -0,0 +1,117 @@
+#include "table.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/MathExtras.h>
+
+size_t const table_index_t::block_size;
+
+namespace
+{
+
+// Elements are zero-extended, like 'getElementAsInteger' does.
+template <class Element>
+void copy_elements(llvm::StringRef data, std::vector<scalar_t> & values)
+{
+    size_t const n = data.size() / sizeof(Element);
+    values.resize(n);
+    for (size_t i = 0; i != n; ++i)
+    {
+        Element e;
+        std::memcpy(&e, data.data() + i * sizeof(Element), sizeof(Element));
+        values[i] = scalar_t(e);
+    }
+}
+
+}
+
+table_index_t::table_index_t(llvm::ConstantDataSequential const & table)
+{
+    llvm::StringRef data = table.getRawDataValues();
+    switch (table.getElementByteSize())
+    {
+    case 1:
+        copy_elements<uint8_t>(data, values_);
+        break;
+    case 2:
+        copy_elements<uint16_t>(data, values_);
+        break;
+    case 4:
+        copy_elements<uint32_t>(data, values_);
+        break;
+    default:
+        copy_elements<uint64_t>(data, values_);
+        break;
+    }
+
+    size_t const blocks = (values_.size() + block_size - 1) / block_size;
+    if (!blocks)
+        return;
+
+    mins_.emplace_back(blocks);
+    maxs_.emplace_back(blocks);
+    for (size_t b = 0; b != blocks; ++b)
+    {
+        auto r = scan(b * block_size, std::min(values_.size(), (b + 1) * block_size) - 1);
+        mins_[0][b] = r.first;
+        maxs_[0][b] = r.second;
+    }
+
+    for (size_t k = 1; (size_t(1) << k) <= blocks; ++k)
+    {
+        size_t const half = size_t(1) << (k - 1);
+        size_t const count = blocks - (size_t(1) << k) + 1;
+        mins_.emplace_back(count);
+        maxs_.emplace_back(count);
+        for (size_t b = 0; b != count; ++b)
+        {
+            mins_[k][b] = std::min(mins_[k - 1][b], mins_[k - 1][b + half]);
+            maxs_[k][b] = std::max(maxs_[k - 1][b], maxs_[k - 1][b + half]);
+        }
+    }
+}
+
+std::pair<scalar_t, scalar_t> table_index_t::minmax(size_t first, size_t last) const
+{
+    size_t const first_block = (first + block_size - 1) / block_size,
+                 last_block = (last + 1) / block_size;
+    if (first_block >= last_block)
+        return scan(first, last);
+
+    // Whole blocks first_block..last_block-1 are covered by two overlapping
+    // runs of 2^k blocks.
+    size_t const k = llvm::Log2_64(last_block - first_block);
+    std::pair<scalar_t, scalar_t> res(
+        std::min(mins_[k][first_block], mins_[k][last_block - (size_t(1) << k)]),
+        std::max(maxs_[k][first_block], maxs_[k][last_block - (size_t(1) << k)]));
+
+    if (first != first_block * block_size)
+    {
+        auto r = scan(first, first_block * block_size - 1);
+        res.first = std::min(res.first, r.first);
+        res.second = std::max(res.second, r.second);
+    }
+
+    if (last + 1 != last_block * block_size)
+    {
+        auto r = scan(last_block * block_size, last);
+        res.first = std::min(res.first, r.first);
+        res.second = std::max(res.second, r.second);
+    }
+
+    return res;
+}
+
+std::pair<scalar_t, scalar_t> table_index_t::scan(size_t first, size_t last) const
+{
+    scalar_t lo = values_[first], hi = values_[first];
+    for (size_t i = first + 1; i <= last; ++i)
+    {
+        lo = std::min(lo, values_[i]);
+        hi = std::max(hi, values_[i]);
+    }
+
+    return {lo, hi};
+}
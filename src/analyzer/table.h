@@ -0,0 +1,38 @@
+#pragma once
+
+#include "common.h"
+
+#include <utility>
+#include <vector>
+
+#include <llvm/IR/Constants.h>
+
+// Range minimum and maximum index over elements of a constant integer table.
+//
+// Elements are split into blocks of 'block_size'. Minimum and maximum of every
+// block are kept in a sparse table, so a query takes constant time for whole
+// blocks plus a linear scan of at most two partial blocks. Scans work on a
+// flat array and are simple enough for the compiler to vectorize.
+struct table_index_t
+{
+    explicit table_index_t(llvm::ConstantDataSequential const &);
+
+    size_t size() const { return values_.size(); }
+
+    // Minimum and maximum of elements first..last, both inclusive.
+    // Requires first <= last < size().
+    std::pair<scalar_t, scalar_t> minmax(size_t first, size_t last) const;
+
+    static size_t const block_size = 64;
+
+private:
+    std::pair<scalar_t, scalar_t> scan(size_t first, size_t last) const;
+
+private:
+    // Elements of the table as 'llvm::ConstantDataSequential::getElementAsInteger'
+    // returns them.
+    std::vector<scalar_t> values_;
+    // mins_[k][b], maxs_[k][b] are minimum and maximum of blocks b..b+2^k-1.
+    std::vector<std::vector<scalar_t>> mins_;
+    std::vector<std::vector<scalar_t>> maxs_;
+};
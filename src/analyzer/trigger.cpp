@@ -6,3 +6,20 @@ trigger_t::trigger_t(sym_expr lhs, sym_expr rhs, llvm::Instruction const & instr
     , instr(&instr)
 {
 }
+
+void trigger_map_t::add(llvm::Function const * func, trigger_t const & trigger)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    triggers_.emplace(func, trigger);
+}
+
+std::vector<trigger_t> trigger_map_t::get(llvm::Function const * func) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<trigger_t> res;
+    auto range = triggers_.equal_range(func);
+    for (auto it = range.first; it != range.second; ++it)
+        res.push_back(it->second);
+
+    return res;
+}
@@ -2,6 +2,11 @@
 
 #include "symbolic/expr.h"
 
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <llvm/IR/Function.h>
 #include <llvm/IR/Instruction.h>
 
 // Trigger is a representation of a condition which leads to buffer overflow.
@@ -15,3 +20,17 @@ struct trigger_t
 
     trigger_t(sym_expr lhs, sym_expr rhs, llvm::Instruction const & instr);
 };
+
+// Triggers of analyzed functions.
+// Functions may be analyzed in parallel, so access is synchronized. Callee is
+// always analyzed before its callers, so by the time triggers of a function
+// are requested, they are complete.
+struct trigger_map_t
+{
+    void add(llvm::Function const *, trigger_t const &);
+    std::vector<trigger_t> get(llvm::Function const *) const;
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_multimap<llvm::Function const *, trigger_t> triggers_;
+};
@@ -0,0 +1,90 @@
+#include "batch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+
+namespace fs = boost::filesystem;
+
+namespace
+{
+
+// Everything produced by analysis of a single module.
+struct module_result_t
+{
+    std::string res;
+    std::string warn;
+    std::string debug;
+    analyzer_t::totals_t totals;
+    bool ok;
+};
+
+module_result_t analyze_one(fs::path const & p, batch_options_t const & options)
+{
+    module_result_t result;
+    {
+        llvm::raw_string_ostream res_out(result.res);
+        llvm::raw_string_ostream warn_out(result.warn);
+        llvm::raw_string_ostream debug_out(result.debug);
+        // 'llvm::nulls()' is buffered, so it can't be shared between threads
+        llvm::raw_null_ostream null_out;
+        analyzer_t analyzer(options.analyzer, res_out, warn_out,
+                            options.verbose ? static_cast<llvm::raw_ostream &>(debug_out) : null_out);
+        result.ok = analyzer.analyze_file(p);
+        result.totals = analyzer.totals();
+    }
+
+    return result;
+}
+
+}
+
+unsigned analyze_files(std::vector<fs::path> const & inputs,
+                       batch_options_t const & options,
+                       llvm::raw_ostream & res_out,
+                       llvm::raw_ostream & warn_out,
+                       llvm::raw_ostream & debug_out)
+{
+    std::vector<module_result_t> results(inputs.size());
+    std::atomic<size_t> next(0);
+    auto worker = [&]()
+    {
+        for (size_t i = next++; i < inputs.size(); i = next++)
+            results[i] = analyze_one(inputs[i], options);
+    };
+
+    unsigned jobs = std::max(1u, std::min<unsigned>(options.jobs, inputs.size()));
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < jobs; ++i)
+        threads.emplace_back(worker);
+
+    worker();
+    for (auto & t : threads)
+        t.join();
+
+    analyzer_t::totals_t totals = {0, 0, 0};
+    unsigned failed = 0;
+    for (size_t i = 0; i != results.size(); ++i)
+    {
+        module_result_t const & result = results[i];
+        debug_out << result.debug;
+        warn_out << result.warn;
+        res_out << "Module " << inputs[i].string() << ":\n"
+                << result.res;
+
+        totals.overflows += result.totals.overflows;
+        totals.indeterminate += result.totals.indeterminate;
+        totals.correct += result.totals.correct;
+        if (!result.ok)
+            ++failed;
+    }
+
+    res_out << "Analyzed " << inputs.size() - failed << " of " << inputs.size() << " modules"
+            << ", total number of possible overflows: " << totals.overflows
+            << ", total number of indeterminate cases: " << totals.indeterminate
+            << ", total number of correct memory usages: " << totals.correct
+            << "\n";
+
+    return failed;
+}
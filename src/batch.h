@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "analyzer/analyzer.h"
+
+#include <llvm/Support/raw_ostream.h>
+
+struct batch_options_t
+{
+    analyzer_options_t analyzer;
+    bool verbose;
+    // number of worker threads
+    unsigned jobs;
+};
+
+// Analyze given modules on a pool of worker threads. Every module is analyzed
+// with its own LLVMContext and analyzer, so workers don't share any state.
+// Output of each module is buffered and printed in the order of inputs
+// followed by totals over all modules, so the result doesn't depend on
+// scheduling.
+//
+// Returns number of modules which failed to be analyzed.
+unsigned analyze_files(std::vector<boost::filesystem::path> const &,
+                       batch_options_t const &,
+                       llvm::raw_ostream & res_out,
+                       llvm::raw_ostream & warn_out,
+                       llvm::raw_ostream & debug_out);
@@ -19,7 +19,7 @@ scalar_t extract_const(llvm::ConstantInt const & i)
 
 boost::optional<scalar_t> extract_const_maybe(llvm::Value const * v)
 {
-    if (auto i = dynamic_cast<llvm::ConstantInt const *>(v))
+    if (auto i = llvm::dyn_cast_or_null<llvm::ConstantInt>(v))
         return extract_const(*i);
 
     return boost::none;
@@ -28,7 +28,7 @@ boost::optional<scalar_t> extract_const_maybe(llvm::Value const * v)
 monotony_t does_monotonically_depend(var_id dependent, var_id x)
 {
     // currently we only consuder binary operators
-    if (auto bin_op = dynamic_cast<llvm::BinaryOperator const *>(dependent))
+    if (auto bin_op = llvm::dyn_cast_or_null<llvm::BinaryOperator>(dependent))
     {
         var_id op0 = bin_op->getOperand(0), op1 = bin_op->getOperand(1);
         if (op0 != x && op1 != x)
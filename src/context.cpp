@@ -1 +1,11 @@
 #include "context.h"
+#include "analyzer/slice.h"
+
+void context_t::set_function(llvm::Function const * func)
+{
+    numbering.reset(func ? compute_access_slice(*func) : std::vector<var_id>());
+    use_ranges.clear();
+    def_ranges.renumber();
+    new_val_set.renumber();
+    vulnerability_info.renumber();
+}
@@ -2,17 +2,24 @@
 
 #include "common.h"
 #include "symbolic.h"
+#include "analyzer/numbering.h"
+#include "analyzer/table.h"
 #include "analyzer/trigger.h"
 
-#include <unordered_map>
-#include <unordered_set>
+#include <functional>
+#include <utility>
+#include <memory>
 
 #include <boost/logic/tribool.hpp>
 
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/Analysis/TargetLibraryInfo.h>
 #include <llvm/IR/Dominators.h>
 
-using new_val_set_t = std::unordered_set<var_id>;
+using new_val_set_t = value_set_t;
+
+// Use range of a value depends only on the block of the program point.
+using use_range_key_t = std::pair<var_id, llvm::BasicBlock const *>;
 
 struct vulnerability_info_t
 {
@@ -51,15 +58,37 @@ namespace std {
 
 struct context_t
 {
+    // Numbering of values of the function being analyzed. Caches below are
+    // indexed by it.
+    value_numbering_t numbering;
     // Cached define ranges.
-    std::unordered_map<var_id, sym_range> def_ranges;
+    value_map_t<sym_range> def_ranges{numbering};
     // NewValSet as specified in the paper. Is used to resolve cyclic dependencies.
-    new_val_set_t new_val_set;
+    new_val_set_t new_val_set{numbering};
+    // Cached use ranges. Only ranges which don't depend on temporary ranges
+    // of values from 'new_val_set' are stored, because those may be
+    // tightened later.
+    llvm::DenseMap<use_range_key_t, sym_range> use_ranges;
+    // Number of reads of temporary define ranges. Is used to detect use
+    // ranges which can't be cached.
+    unsigned temporary_reads = 0;
+    // Min/max indices of constant tables read by loads. They are built on the
+    // first load from a table and are shared by all loads from it.
+    llvm::DenseMap<llvm::ConstantDataSequential const *, std::unique_ptr<table_index_t>> table_indices;
     // Vulnerability information is cached to avoid computing it multiple times.
-    std::unordered_map<var_id, vulnerability_info_t> vulnerability_info;
+    value_map_t<vulnerability_info_t> vulnerability_info{numbering};
+    // Number of cyclic components whose ranges are being widened. Ranges
+    // computed meanwhile may be based on unstable ranges and aren't cached.
+    unsigned widening_depth = 0;
     // Some helpful LLVM passes.
     llvm::TargetLibraryInfoWrapperPass tliwp;
     llvm::DominatorTreeWrapperPass dtwp;
-    // Triggers used by interprocedural analysis.
-    std::unordered_multimap<llvm::Function const *, trigger_t> triggers;
+    // Triggers used by interprocedural analysis. They are shared by all
+    // contexts which analyze functions of the same module.
+    std::shared_ptr<trigger_map_t> triggers = std::make_shared<trigger_map_t>();
+
+    // Number values of the given function which can be needed for checking
+    // its memory accesses. Cached information about values of the previous
+    // one is dropped.
+    void set_function(llvm::Function const *);
 };
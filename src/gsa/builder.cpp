@@ -1,19 +1,33 @@
 #include "builder.h"
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <unordered_map>
-#include <unordered_set>
 
+#include <llvm/IR/CFG.h>
 #include <llvm/IR/Dominators.h>
 #include <llvm/IR/Function.h>
 
+// Gating conditions of phis of a single function. They are built once and
+// never change afterwards, so they are read without locking.
+struct gsa_builder_t::function_gsa_t
+{
+    std::once_flag built;
+    gating_dag_t dag;
+    // of phis and selects
+    std::unordered_map<llvm::Instruction const *, std::vector<gating_cond_t const *>> conditions;
+};
+
 struct gsa_builder_t::impl_t
 {
-    std::unordered_map<llvm::PHINode const *, std::vector<gating_cond_ptr_t>> conditions;
-    llvm::DominatorTreeWrapperPass dtwp;
-    std::unordered_map<llvm::Value const *, std::pair<llvm::Value const *, llvm::ICmpInst::Predicate>> preds;
-    std::unordered_set<llvm::BasicBlock const *> visited_blocks;
+    // Every function of the module has its slot from the start, so the map
+    // is never modified while it's queried and needs no lock.
+    std::unordered_map<llvm::Function const *, std::unique_ptr<function_gsa_t>> functions;
+    std::atomic<size_t> built{0};
 };
 
 gsa_builder_t::gsa_builder_t()
@@ -25,209 +39,244 @@ gsa_builder_t::~gsa_builder_t()
 {
 }
 
-void gsa_builder_t::build(llvm::Module const & module)
+void gsa_builder_t::reset(llvm::Module const & module)
 {
+    clear();
     for (auto const & f : module)
-        process_function(f);
+        pimpl().functions[&f].reset(new function_gsa_t);
 }
 
-void gsa_builder_t::process_function(llvm::Function const & func)
+// Functions are independent, so they are built by a pool of threads taking
+// them one by one.
+void gsa_builder_t::build(llvm::Module const & module, unsigned jobs)
 {
-    pimpl().dtwp.runOnFunction(*const_cast<llvm::Function *>(&func));
+    reset(module);
+    std::vector<llvm::Function const *> functions;
+    for (auto const & f : module)
+    {
+        if (!f.isDeclaration())
+            functions.push_back(&f);
+    }
 
-    llvm::DominatorTree const & dom_tree = pimpl().dtwp.getDomTree();
-    for (auto const & bb : func)
-        process_basic_block_recursive(bb, dom_tree);
+    std::atomic<size_t> next(0);
+    auto worker = [&]()
+    {
+        for (size_t i = next++; i < functions.size(); i = next++)
+            get_function(*functions[i]);
+    };
+
+    jobs = std::max(1u, std::min<unsigned>(jobs, functions.size()));
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < jobs; ++i)
+        threads.emplace_back(worker);
+
+    worker();
+    for (auto & t : threads)
+        t.join();
 }
 
-namespace
+void gsa_builder_t::clear()
 {
+    pimpl().functions.clear();
+    pimpl().built = 0;
+}
 
-bool is_linkable(llvm::BasicBlock const * v, llvm::BasicBlock const * w,
-                 llvm::DominatorTree const & DT)
+size_t gsa_builder_t::built_functions() const
 {
-    std::vector<llvm::Value const *> storage;
-    storage.push_back(v);
+    return pimpl().built;
+}
 
-    if (!DT.isReachableFromEntry(w))
-      return false;
+gsa_builder_t::function_gsa_t * gsa_builder_t::get_function(llvm::Function const & func)
+{
+    auto it = pimpl().functions.find(&func);
+    if (it == pimpl().functions.end())
+        return nullptr;
 
-    while (v != w && storage.size())
+    // other threads querying the same function wait here until it's built
+    function_gsa_t & gsa = *it->second;
+    std::call_once(gsa.built, [&]()
     {
-        llvm::Value const * val = storage.back();
-        storage.pop_back();
+        process_function(func, gsa);
+        ++pimpl().built;
+    });
 
-        if (llvm::BasicBlock const * bb = dynamic_cast<llvm::BasicBlock const *>(val))
-        {
-            if (bb == w)
-              return true;
-            if (DT.dominates(bb, w))
-              return false;
+    return &gsa;
+}
 
-            if (bb != v)
-            {
-                std::copy(llvm::succ_begin(bb), llvm::succ_end(bb), std::back_inserter(storage));
-            }
+// Gating condition of the incoming edge 'pred' -> 'bb' of phis of 'bb' is a
+// conjunction of branch conditions on the way to it from 'dominator', the
+// immediate dominator of 'bb' (switches are branches with many successors):
+// 1. conditions of branches of dominators of 'pred' below 'dominator', which
+//    go to a successor having no other predecessors and dominating 'pred'.
+//    After the last time such branch is taken before reaching 'bb', control
+//    goes through this successor, so the condition holds on the edge;
+// 2. the condition of the branch in 'pred' which goes to 'bb'.
+// Only the path between the edge and 'dominator' is used, conditions above
+// it hold in 'bb' as well and are handled as its predicates. Condition of the
+// path to a block is its idom's one with the block's own literal, so it's
+// memoized per block for every 'dominator' and each block of a region is
+// processed once however many edges leave it.
+// Values of a select are gated by its condition and its negation.
+void gsa_builder_t::process_function(llvm::Function const & func, function_gsa_t & gsa) const
+{
+    if (func.isDeclaration())
+        return;
+
+    llvm::DominatorTree dom_tree(const_cast<llvm::Function &>(func));
+
+    // Literal of the branch from 'from' to its successor 'to' if it's
+    // conditional.
+    auto branch_literal = [](llvm::BasicBlock const * from, llvm::BasicBlock const * to,
+                             gating_literal_t & literal)
+    {
+        auto terminator = from->getTerminator();
+        if (auto sw = llvm::dyn_cast<llvm::SwitchInst>(terminator))
+        {
+            literal = {sw, false, to};
+            return sw->getNumCases() != 0;
         }
-    }
 
-    return true;
-}
+        auto br = llvm::dyn_cast<llvm::BranchInst>(terminator);
+        if (!br || br->isUnconditional() || br->getSuccessor(0) == br->getSuccessor(1))
+            return false;
 
-}
+        if (br->getSuccessor(0) == to)
+            literal = {br->getCondition(), false, nullptr};
+        else if (br->getSuccessor(1) == to)
+            literal = {br->getCondition(), true, nullptr};
+        else
+            return false;
 
-// This function traverses basic blocks from function's CFG in depth-first order.
-// Here we compute gating paths and build gating functions.
-void gsa_builder_t::process_basic_block_recursive(llvm::BasicBlock const & bb, llvm::DominatorTree const & dt)
-{
-    if (pimpl().visited_blocks.count(&bb))
-        return;
+        return true;
+    };
 
-    pimpl().visited_blocks.insert(&bb);
-    for (auto const & instr : bb)
+    // paths[dominator][bb] is condition of the path from 'dominator' to 'bb'
+    using path_conds_t = std::unordered_map<llvm::BasicBlock const *, gating_cond_t const *>;
+    std::unordered_map<llvm::BasicBlock const *, path_conds_t> paths;
+    std::vector<llvm::DomTreeNode const *> unknown;
+    auto path_cond = [&](llvm::BasicBlock const * bb, llvm::BasicBlock const * dominator)
     {
-        if (auto phi = dynamic_cast<llvm::PHINode const *>(&instr))
+        path_conds_t & known = paths[dominator];
+        gating_cond_t const * cond = nullptr;
+        unknown.clear();
+        for (llvm::DomTreeNode const * node = dom_tree.getNode(bb);
+             node && node->getBlock() != dominator && node->getIDom();
+             node = node->getIDom())
         {
-            unsigned n = phi->getNumIncomingValues();
-            for (size_t i = 0; i != n; ++i)
+            auto it = known.find(node->getBlock());
+            if (it != known.end())
             {
-                llvm::Value const * inc_val = phi->getIncomingValue(i);
-                auto iter = pimpl().conditions.find(phi);
-                if (iter != pimpl().conditions.end())
-                {
-                    if (iter->second.size() <= i)
-                        continue;
-
-                    gating_cond_ptr_t old_cond = iter->second[i];
-                    gating_cond_ptr_t to_conjunct = construct_gating_cond(inc_val, false);
-                    gating_cond_ptr_t new_cond = std::make_shared<conjuncted_gating_cond_t>(old_cond, to_conjunct);
-                    pimpl().conditions[phi][i] = std::move(new_cond);
-//                    pimpl().conditions.erase(iter);
-//                    auto to_insert = std::make_pair(phi, );
-//                    pimpl().conditions.insert(std::move(to_insert));
-                }
-                else if (pimpl().conditions[phi].size())
-                {
-                    pimpl().conditions[phi][i] = construct_gating_cond(inc_val, true);
-                }
+                cond = it->second;
+                break;
             }
 
-            if (n == 2 && pimpl().conditions[phi].size())
-            {
-                gating_cond_ptr_t lhs = construct_gating_cond(phi->getIncomingValue(0), false);
-                gating_cond_ptr_t rhs = construct_gating_cond(phi->getIncomingValue(1), false);
-                gating_cond_ptr_t conj = std::make_shared<conjuncted_gating_cond_t>(lhs, rhs);
-                pimpl().conditions[phi].push_back(conj);
-                pimpl().conditions[phi].push_back(rhs);
-            }
+            unknown.push_back(node);
         }
-        if (auto cmp_inst = dynamic_cast<llvm::ICmpInst const *>(&instr))
+
+        // conditions are built from the top of the region, so that paths in
+        // the same region share nodes of their common conditions
+        for (auto it = unknown.rbegin(); it != unknown.rend(); ++it)
         {
-            auto op0 = cmp_inst->getOperand(0);
-            auto op1 = cmp_inst->getOperand(1);
-            switch (cmp_inst->getPredicate())
-            {
-            case llvm::ICmpInst::ICMP_EQ:
-                {
-                    pimpl().preds[op0] = std::make_pair(op1, llvm::ICmpInst::ICMP_NE);
-                    pimpl().preds[op1] = std::make_pair(op0, llvm::ICmpInst::ICMP_NE);
-                    break;
-                }
-            case llvm::ICmpInst::ICMP_NE:
-                {
-                    pimpl().preds[op0] = std::make_pair(op1, llvm::ICmpInst::ICMP_EQ);
-                    pimpl().preds[op1] = std::make_pair(op0, llvm::ICmpInst::ICMP_EQ);
-                    break;
-                }
-            case llvm::ICmpInst::ICMP_UGT:
-            case llvm::ICmpInst::ICMP_SGT:
-                {
-                    pimpl().preds[op0] = std::make_pair(op1, llvm::ICmpInst::ICMP_UGT);
-                    pimpl().preds[op1] = std::make_pair(op0, llvm::ICmpInst::ICMP_ULE);
-                    break;
-                }
-            case llvm::ICmpInst::ICMP_UGE:
-            case llvm::ICmpInst::ICMP_SGE:
-                {
-                    pimpl().preds[op0] = std::make_pair(op1, llvm::ICmpInst::ICMP_UGE);
-                    pimpl().preds[op1] = std::make_pair(op0, llvm::ICmpInst::ICMP_ULT);
-                    break;
-                }
-            case llvm::ICmpInst::ICMP_ULT:
-            case llvm::ICmpInst::ICMP_SLT:
-                {
-                    pimpl().preds[op0] = std::make_pair(op1, llvm::ICmpInst::ICMP_ULT);
-                    pimpl().preds[op1] = std::make_pair(op0, llvm::ICmpInst::ICMP_UGE);
-                    break;
-                }
-            case llvm::ICmpInst::ICMP_ULE:
-            case llvm::ICmpInst::ICMP_SLE:
-                {
-                    pimpl().preds[op0] = std::make_pair(op1, llvm::ICmpInst::ICMP_ULE);
-                    pimpl().preds[op1] = std::make_pair(op0, llvm::ICmpInst::ICMP_UGT);
-                    break;
-                }
-            default:
-                {
-                }
-            }
+            llvm::BasicBlock const * cur = (*it)->getBlock();
+            llvm::BasicBlock const * idom = (*it)->getIDom()->getBlock();
+            gating_literal_t literal;
+            if (cur->getUniquePredecessor() == idom && branch_literal(idom, cur, literal))
+                cond = gsa.dag.conjunct(cond, literal);
+
+            known.emplace(cur, cond);
         }
-        if (auto terminator = dynamic_cast<llvm::TerminatorInst const *>(&instr))
+
+        return cond;
+    };
+
+    // The walk from 'pred' may pass 'bb' itself on a back edge, but 'bb' has
+    // several predecessors and its idom is 'dominator', so nothing is added
+    // above it.
+    auto edge_cond = [&](llvm::BasicBlock const * pred, llvm::BasicBlock const * bb,
+                         llvm::BasicBlock const * dominator) -> gating_cond_t const *
+    {
+        if (!dom_tree.isReachableFromEntry(pred))
+            return nullptr;
+
+        gating_cond_t const * cond = path_cond(pred, dominator);
+        gating_literal_t literal;
+        if (branch_literal(pred, bb, literal))
+            cond = gsa.dag.conjunct(cond, literal);
+
+        return cond;
+    };
+
+    std::unordered_map<llvm::BasicBlock const *, gating_cond_t const *> incoming;
+    for (auto const & bb : func)
+    {
+        if (!llvm::isa<llvm::PHINode>(bb.front()))
+            continue;
+
+        llvm::DomTreeNode const * node = dom_tree.getNode(&bb);
+        if (!node || !node->getIDom())
+            continue;
+
+        // all phis of a block share conditions of its incoming edges
+        incoming.clear();
+        for (llvm::BasicBlock const * pred : llvm::predecessors(&bb))
         {
-            for (unsigned i = 0; i != terminator->getNumSuccessors(); ++i)
-            {
-                llvm::BasicBlock const * succ = terminator->getSuccessor(i);
-                if (succ)
-                {
-                    process_basic_block_recursive(*succ, dt);
-                }
-            }
+            if (!incoming.count(pred))
+                incoming.emplace(pred, edge_cond(pred, &bb, node->getIDom()->getBlock()));
         }
-    }
-}
 
-// subroot function as defined in the paper
-// it's sibling of 'v' dominating 'w'
-llvm::Instruction const * gsa_builder_t::subroot(llvm::Instruction const * instr)
-{
-    llvm::BasicBlock const * parent = instr->getParent();
-    llvm::TerminatorInst const * par_term = parent->getTerminator();
+        for (auto const & instr : bb)
+        {
+            auto phi = llvm::dyn_cast<llvm::PHINode>(&instr);
+            if (!phi)
+                break;
 
-    if (dynamic_cast<llvm::ReturnInst const *>(par_term))
-        return nullptr;
+            std::vector<gating_cond_t const *> & conditions = gsa.conditions[phi];
+            for (unsigned i = 0; i != phi->getNumIncomingValues(); ++i)
+                conditions.push_back(incoming[phi->getIncomingBlock(i)]);
+        }
+    }
 
-    else if (auto br_instr = dynamic_cast<llvm::BranchInst const *>(par_term))
+    for (auto const & bb : func)
     {
-        unsigned n = br_instr->getNumSuccessors();
-        for (unsigned i = 0; i != n; ++i)
+        for (auto const & instr : bb)
         {
-            llvm::BasicBlock const * succ = br_instr->getSuccessor(i);
-            if (succ)
-            {
-                return &(succ->front());
-            }
+            auto select = llvm::dyn_cast<llvm::SelectInst>(&instr);
+            if (!select || !select->getCondition()->getType()->isIntegerTy(1))
+                continue;
+
+            llvm::Value const * cond = select->getCondition();
+            gsa.conditions[select] = {gsa.dag.intern({{cond, false, nullptr}}),
+                                      gsa.dag.intern({{cond, true, nullptr}})};
         }
     }
+}
 
-    return par_term;
+gating_cond_t const * gsa_builder_t::get_gating_condition(llvm::PHINode const & phi, unsigned i)
+{
+    return find_gating_condition(phi, i);
 }
 
-gating_cond_ptr_t gsa_builder_t::construct_gating_cond(llvm::Value const * val, bool negate) const
+gating_cond_t const * gsa_builder_t::get_gating_condition(llvm::SelectInst const & select, unsigned i)
 {
-    if (negate)
-        return std::make_shared<simple_gating_cond_t>(val);
-    else
-        return std::make_shared<negated_gating_cond_t>(val);
+    return find_gating_condition(select, i);
 }
 
-gating_cond_t const * gsa_builder_t::get_gating_condition(llvm::PHINode const & phi, unsigned i) const
+gating_cond_t const * gsa_builder_t::find_gating_condition(llvm::Instruction const & instr, unsigned i)
 {
-    auto const & conditions = pimpl().conditions;
-    auto it = conditions.find(&phi);
+    llvm::Function const * func = instr.getParent() ? instr.getParent()->getParent() : nullptr;
+    if (!func)
+        return nullptr;
+
+    function_gsa_t const * gsa = get_function(*func);
+    if (!gsa)
+        return nullptr;
+
+    auto const & conditions = gsa->conditions;
+    auto it = conditions.find(&instr);
     if (it == conditions.end())
         return nullptr;
     else if (it->second.size() > i)
-        return it->second[i].get();
+        return it->second[i];
     else
         return nullptr;
 }
@@ -15,23 +15,34 @@ struct gsa_builder_t
 
     ~gsa_builder_t();
 
-    // build GSA form
-    void build(llvm::Module const &);
+    // prepare for queries about functions of the module, GSA form of a
+    // function is built on the first query of its gating conditions
+    void reset(llvm::Module const &);
 
-    // all functions are processed separately
-    void process_function(llvm::Function const &);
+    // build GSA form of all functions of the module on 'jobs' threads
+    void build(llvm::Module const &, unsigned jobs = 1);
 
-    // here we process basic blocks in depth first order
-    void process_basic_block_recursive(llvm::BasicBlock const &, llvm::DominatorTree const &);
+    // forget all functions
+    void clear();
 
-    // compute subroot (according to the paper)
-    llvm::Instruction const * subroot(llvm::Instruction const *);
+    // number of functions which have GSA form built
+    size_t built_functions() const;
 
-    // compute gating condition
-    gating_cond_ptr_t construct_gating_cond(llvm::Value const *, bool negate) const;
+    // returns gating condition for the i-th argument of give phi node if it is known,
+    // may be called from several threads, but not together with other methods
+    gating_cond_t const * get_gating_condition(llvm::PHINode const &, unsigned index);
 
-    // returns gating condition for the i-th argument of give phi node if it is known
-    gating_cond_t const * get_gating_condition(llvm::PHINode const &, unsigned index) const;
+    // the same for the true (0) and the false (1) value of a select
+    gating_cond_t const * get_gating_condition(llvm::SelectInst const &, unsigned index);
+
+private:
+    struct function_gsa_t;
+
+    // all functions are processed separately, state of the builder which
+    // isn't a result lives only while a function is processed
+    void process_function(llvm::Function const &, function_gsa_t &) const;
+    function_gsa_t * get_function(llvm::Function const &);
+    gating_cond_t const * find_gating_condition(llvm::Instruction const &, unsigned index);
 
 private:
     struct impl_t;
@@ -1,22 +1,35 @@
 #include "cond.h"
 
-gating_cond_t::~gating_cond_t()
-{
-}
+#include <unordered_set>
 
-simple_gating_cond_t::simple_gating_cond_t(llvm::Value const * val)
-    : predicate(val)
+gating_cond_t::gating_cond_t(gating_cond_t const * parent, gating_literal_t literal)
+    : parent_(parent)
+    , literal_(literal)
 {
 }
 
-negated_gating_cond_t::negated_gating_cond_t(llvm::Value const * val)
-    : predicate(val)
+gating_cond_t const * gating_dag_t::intern(std::vector<gating_literal_t> const & literals)
 {
+    gating_cond_t const * cond = nullptr;
+    std::unordered_set<gating_literal_t> seen;
+    for (gating_literal_t const & literal : literals)
+    {
+        if (seen.insert(literal).second)
+            cond = conjunct(cond, literal);
+    }
+
+    return cond;
 }
 
-conjuncted_gating_cond_t::conjuncted_gating_cond_t(gating_cond_ptr_t lhs,
-                                                   gating_cond_ptr_t rhs)
-    : lhs(lhs)
-    , rhs(rhs)
+gating_cond_t const * gating_dag_t::conjunct(gating_cond_t const * cond, gating_literal_t literal)
 {
+    gating_key_t key = {cond, literal};
+    auto it = index_.find(key);
+    if (it != index_.end())
+        return it->second;
+
+    nodes_.push_back(gating_cond_t(cond, literal));
+    gating_cond_t const * node = &nodes_.back();
+    index_.emplace(key, node);
+    return node;
 }
@@ -1,36 +1,104 @@
 #pragma once
 
-#include <memory>
+#include <deque>
+#include <functional>
+#include <unordered_map>
+#include <vector>
 
+#include <llvm/IR/BasicBlock.h>
 #include <llvm/IR/Value.h>
 
-// Gating condition
-
-struct gating_cond_t
+// Literal of a gating condition: condition of a branch or a select, or its
+// negation, or a 'SwitchInst' going to 'successor'.
+struct gating_literal_t
 {
-    virtual ~gating_cond_t();
-};
+    llvm::Value const * predicate;
+    bool negated;
+    llvm::BasicBlock const * successor;
 
-using gating_cond_ptr_t = std::shared_ptr<gating_cond_t>;
+    bool operator==(gating_literal_t const & other) const
+    {
+        return predicate == other.predicate && negated == other.negated
+                && successor == other.successor;
+    }
+};
 
-struct simple_gating_cond_t : gating_cond_t
+// Gating condition is a conjunction of literals.
+//
+// Conditions of a function are interned in its 'gating_dag_t': every
+// condition is a node made of a shorter condition and one more literal, and
+// equal conditions are the same node, so they can be compared and hashed by
+// address. Conditions built from the same prefix share its nodes.
+struct gating_cond_t
 {
-    simple_gating_cond_t(llvm::Value const *);
+    // the same condition without the last literal, nullptr if it's the only one
+    gating_cond_t const * parent() const { return parent_; }
+    gating_literal_t const & literal() const { return literal_; }
 
-    llvm::Value const * predicate;
+private:
+    friend struct gating_dag_t;
+    gating_cond_t(gating_cond_t const * parent, gating_literal_t literal);
+
+    gating_cond_t const * parent_;
+    gating_literal_t literal_;
 };
 
-struct negated_gating_cond_t : gating_cond_t
+// Key which identifies gating condition structurally.
+struct gating_key_t
 {
-    negated_gating_cond_t(llvm::Value const *);
+    gating_cond_t const * parent;
+    gating_literal_t literal;
 
-    llvm::Value const * predicate;
+    bool operator==(gating_key_t const & other) const
+    {
+        return parent == other.parent && literal == other.literal;
+    }
 };
 
-struct conjuncted_gating_cond_t : gating_cond_t
+namespace std {
+
+  template <>
+  struct hash<gating_literal_t>
+  {
+    std::size_t operator()(gating_literal_t const & literal) const
+    {
+      std::size_t h = hash<void const *>()(literal.predicate);
+      h = h * 31 + hash<void const *>()(literal.successor);
+      return h * 31 + literal.negated;
+    }
+  };
+
+  template <>
+  struct hash<gating_key_t>
+  {
+    std::size_t operator()(gating_key_t const & key) const
+    {
+      std::size_t h = hash<void const *>()(key.parent);
+      return h * 31 + hash<gating_literal_t>()(key.literal);
+    }
+  };
+
+}
+
+// Storage of gating conditions of a single function.
+struct gating_dag_t
 {
-    conjuncted_gating_cond_t(gating_cond_ptr_t lhs, gating_cond_ptr_t rhs);
+    gating_dag_t() = default;
+    gating_dag_t(gating_dag_t const &) = delete;
+    gating_dag_t & operator=(gating_dag_t const &) = delete;
+
+    // Conjunction of the given literals in the given order, repeated ones are
+    // skipped. Returns nullptr if there are no literals.
+    gating_cond_t const * intern(std::vector<gating_literal_t> const &);
+
+    // The given condition with one more literal, nullptr stands for an empty
+    // condition. The literal isn't checked for being repeated.
+    gating_cond_t const * conjunct(gating_cond_t const *, gating_literal_t);
+
+    size_t size() const { return nodes_.size(); }
+
+private:
 
-    gating_cond_ptr_t lhs;
-    gating_cond_ptr_t rhs;
+    std::deque<gating_cond_t> nodes_;
+    std::unordered_map<gating_key_t, gating_cond_t const *> index_;
 };
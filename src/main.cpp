@@ -1,33 +1,57 @@
+#include <chrono>
+#include <fstream>
 #include <iostream>
+#include <string>
+#include <vector>
 
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
 
 #include "analyzer/analyzer.h"
+#include "batch.h"
 
 namespace po = boost::program_options;
 namespace fs = boost::filesystem;
 
 int main(int argc, char *argv[])
 {
-    bool verbose, print_indeterminate;
+    bool verbose = false, print_indeterminate = false, recursive_def_ranges = false, no_prefilter = false;
+    bool eager_gsa = false;
+    unsigned jobs, function_jobs, function_time_limit, function_def_range_limit, deadline;
+    std::string profile_name;
     po::options_description visible_options("Options");
     visible_options.add_options()
        ("help",                                                                      "display this help")
        ("verbose,v",                 po::value(&verbose)->zero_tokens(),             "be verbose")
        ("indeterminate,n",           po::value(&print_indeterminate)->zero_tokens(), "report indeterminate situations")
+       ("input-list,l",              po::value<std::string>(),                       "file with a list of input files, one per line")
+       ("jobs,j",                    po::value(&jobs)->default_value(1),             "number of modules analyzed in parallel")
+       ("function-jobs",             po::value(&function_jobs)->default_value(1),    "number of threads analyzing functions of a module")
+       ("recursive-def-ranges",      po::value(&recursive_def_ranges)->zero_tokens(), "compute define ranges with the old recursive engine")
+       ("no-prefilter",              po::value(&no_prefilter)->zero_tokens(),        "check all accesses with symbolic analysis only")
+       ("eager-gsa",                 po::value(&eager_gsa)->zero_tokens(),           "build GSA form of all functions before analysis")
+       ("profile",                   po::value(&profile_name)->default_value("balanced"),
+                                                                                     "cost of analysis: fast, balanced or thorough")
+       ("max-expr-size",             po::value<unsigned>(),                          "max number of nodes in a symbolic bound (overrides profile)")
+       ("max-expr-depth",            po::value<unsigned>(),                          "max depth of a symbolic bound (overrides profile)")
+       ("function-time-limit",       po::value(&function_time_limit)->default_value(0),
+                                                                                     "milliseconds per function, 0 for no limit")
+       ("function-def-range-limit",  po::value(&function_def_range_limit)->default_value(0),
+                                                                                     "define range computations per function, 0 for no limit")
+       ("deadline",                  po::value(&deadline)->default_value(0),
+                                                                                     "seconds after which the rest is reported as indeterminate, 0 for none")
        ;
 
     po::options_description hidden_options("Hidden options");
     hidden_options.add_options()
-       ("input",                     po::value<std::string>()->required(), "input file")
+       ("input",                     po::value<std::vector<std::string>>(), "input files")
        ;
 
     po::options_description cmdline_options;
     cmdline_options.add(visible_options).add(hidden_options);
 
     po::positional_options_description p;
-    p.add("input", 1);
+    p.add("input", -1);
 
     po::variables_map vm;
     try
@@ -35,7 +59,7 @@ int main(int argc, char *argv[])
        po::store(po::command_line_parser(argc, argv).options(cmdline_options).positional(p).run(), vm);
        if (vm.count("help"))
        {
-          std::cout << "Usage: " << argv[0] << " [options] file" << std::endl
+          std::cout << "Usage: " << argv[0] << " [options] file..." << std::endl
                     << visible_options << std::endl
                     ;
           return EXIT_SUCCESS;
@@ -53,9 +77,70 @@ int main(int argc, char *argv[])
        return EXIT_FAILURE;
     }
 
-    fs::path input_path(vm["input"].as<std::string>());
-    analyzer_t analyzer(print_indeterminate, llvm::outs(), llvm::errs(), verbose ? llvm::outs() : llvm::nulls());
-    analyzer.analyze_file(input_path);
+    analysis_profile_t profile;
+    if (!parse_analysis_profile(profile_name, profile))
+    {
+        std::cerr << "Unknown profile " << profile_name << std::endl
+                  << "Try using --help option" << std::endl
+                  ;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<fs::path> inputs;
+    if (vm.count("input"))
+    {
+        for (std::string const & input : vm["input"].as<std::vector<std::string>>())
+            inputs.emplace_back(input);
+    }
+
+    if (vm.count("input-list"))
+    {
+        std::string const & list_path = vm["input-list"].as<std::string>();
+        std::ifstream list(list_path);
+        if (!list)
+        {
+            std::cerr << "Failed to open input list " << list_path << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        std::string line;
+        while (std::getline(list, line))
+        {
+            if (!line.empty())
+                inputs.emplace_back(line);
+        }
+    }
+
+    if (inputs.empty())
+    {
+        std::cerr << "No input files given" << std::endl
+                  << "Try using --help option" << std::endl
+                  ;
+        return EXIT_FAILURE;
+    }
+
+    analyzer_options_t analyzer_options = profile_options(profile);
+    analyzer_options.report_indeterminate = print_indeterminate;
+    analyzer_options.jobs = function_jobs;
+    analyzer_options.recursive_def_ranges = recursive_def_ranges;
+    analyzer_options.prefilter = !no_prefilter;
+    analyzer_options.lazy_gsa = !eager_gsa;
+    if (vm.count("max-expr-size"))
+        analyzer_options.max_expr_size = vm["max-expr-size"].as<unsigned>();
+    if (vm.count("max-expr-depth"))
+        analyzer_options.max_expr_depth = vm["max-expr-depth"].as<unsigned>();
+    analyzer_options.function_time_limit_ms = function_time_limit;
+    analyzer_options.function_def_range_limit = function_def_range_limit;
+    if (deadline)
+        analyzer_options.deadline = std::chrono::steady_clock::now() + std::chrono::seconds(deadline);
+
+    if (inputs.size() == 1)
+    {
+        analyzer_t analyzer(analyzer_options, llvm::outs(), llvm::errs(), verbose ? llvm::outs() : llvm::nulls());
+        return analyzer.analyze_file(inputs.front()) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
 
-    return 0;
+    batch_options_t options = {analyzer_options, verbose, jobs};
+    unsigned failed = analyze_files(inputs, options, llvm::outs(), llvm::errs(), llvm::outs());
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
 }
@@ -0,0 +1,25 @@
+#include "arena.h"
+
+atom_arena_t & atom_arena_t::current()
+{
+    static atom_arena_t process_arena;
+    atom_arena_t * arena = current_ptr();
+    return arena ? *arena : process_arena;
+}
+
+atom_arena_t * & atom_arena_t::current_ptr()
+{
+    static thread_local atom_arena_t * arena = nullptr;
+    return arena;
+}
+
+atom_arena_scope_t::atom_arena_scope_t(atom_arena_t & arena)
+    : previous_(atom_arena_t::current_ptr())
+{
+    atom_arena_t::current_ptr() = &arena;
+}
+
+atom_arena_scope_t::~atom_arena_scope_t()
+{
+    atom_arena_t::current_ptr() = previous_;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include <llvm/Support/Allocator.h>
+
+#include "common.h"
+#include "atomic.h"
+
+// Key which identifies symbolic atom structurally.
+// Children of an atom are already interned, so they are compared by address.
+struct atom_key_t
+{
+    sym_atomic::kind_t kind;
+    scalar_t value;
+    void const * lhs;
+    void const * rhs;
+
+    bool operator==(atom_key_t const & other) const
+    {
+        return kind == other.kind && value == other.value
+                && lhs == other.lhs && rhs == other.rhs;
+    }
+};
+
+namespace std {
+
+  template <>
+  struct hash<atom_key_t>
+  {
+    std::size_t operator()(atom_key_t const & key) const
+    {
+      std::size_t h = hash<scalar_t>()(key.value) * 31 + key.kind;
+      h = h * 31 + hash<void const *>()(key.lhs);
+      return h * 31 + hash<void const *>()(key.rhs);
+    }
+  };
+
+}
+
+// Limits on trees of atoms. Expressions whose atoms exceed them are replaced
+// with infinite bounds by range arithmetic.
+struct atom_limits_t
+{
+    unsigned max_size = 1000;
+    unsigned max_depth = 64;
+};
+
+// Storage of symbolic atoms.
+//
+// Atoms are hash-consed: structurally equal atoms are represented by the same
+// node, so they can be compared and hashed by address. Nodes are allocated in
+// bulk and freed all at once when the arena is destroyed, which happens when
+// analysis of a module is finished.
+//
+// Table is split into shards with their own locks, so that worker threads
+// analyzing functions of the same module can share the arena.
+struct atom_arena_t
+{
+    atom_arena_t() = default;
+    atom_arena_t(atom_arena_t const &) = delete;
+    atom_arena_t & operator=(atom_arena_t const &) = delete;
+
+    template <class Atom, class... Args>
+    Atom const * intern(atom_key_t const & key, Args &&... args);
+
+    void set_limits(atom_limits_t limits) { limits_ = limits; }
+    bool exceeds_limits(sym_atomic const & atom) const
+    {
+        return atom.size() > limits_.max_size || atom.depth() > limits_.max_depth;
+    }
+
+    // Number of expressions dropped because of the limits.
+    void count_capped() { ++capped_; }
+    unsigned capped() const { return capped_; }
+
+    // Arena used by the current thread. If no arena was set by
+    // 'atom_arena_scope_t', process-wide one is used.
+    static atom_arena_t & current();
+
+private:
+    friend struct atom_arena_scope_t;
+    static atom_arena_t * & current_ptr();
+
+    struct shard_t
+    {
+        std::mutex mutex;
+        llvm::BumpPtrAllocator allocator;
+        std::unordered_map<atom_key_t, void const *> atoms;
+    };
+
+    static const size_t shards_count = 16;
+    std::array<shard_t, shards_count> shards_;
+    atom_limits_t limits_;
+    std::atomic<unsigned> capped_{0};
+};
+
+// Makes given arena current for this thread while the scope is alive.
+struct atom_arena_scope_t
+{
+    explicit atom_arena_scope_t(atom_arena_t &);
+    ~atom_arena_scope_t();
+
+    atom_arena_scope_t(atom_arena_scope_t const &) = delete;
+    atom_arena_scope_t & operator=(atom_arena_scope_t const &) = delete;
+
+private:
+    atom_arena_t * previous_;
+};
+
+template <class Atom, class... Args>
+Atom const * atom_arena_t::intern(atom_key_t const & key, Args &&... args)
+{
+    shard_t & shard = shards_[std::hash<atom_key_t>()(key) % shards_count];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.atoms.find(key);
+    if (it != shard.atoms.end())
+        return static_cast<Atom const *>(it->second);
+
+    // Atoms are trivially destructible, so nobody needs to call destructors.
+    Atom const * atom = new (shard.allocator.Allocate<Atom>()) Atom(std::forward<Args>(args)...);
+    shard.atoms.emplace(key, atom);
+    return atom;
+}
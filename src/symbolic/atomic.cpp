@@ -1,4 +1,9 @@
 #include "atomic.h"
+#include "arena.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
 
 #include <llvm/Support/raw_ostream.h>
 
@@ -8,22 +13,33 @@ llvm::raw_ostream & operator<<(llvm::raw_ostream & out, sym_atomic const & a)
     return out;
 }
 
-atomic_const::atomic_const(scalar_t val)
-    : val_(val)
+void sym_atomic::print(llvm::raw_ostream & out) const
 {
+    switch (kind_)
+    {
+    case Const: llvm::cast<atomic_const>(this)->print(out); break;
+    case Var: llvm::cast<atomic_var>(this)->print(out); break;
+    case Linear: llvm::cast<atomic_linear>(this)->print(out); break;
+    case BinOp: llvm::cast<atomic_bin_op>(this)->print(out); break;
+    case Sum: llvm::cast<atomic_sum>(this)->print(out); break;
+    }
 }
 
-void atomic_const::print(llvm::raw_ostream & out) const
+atomic_const const * atomic_const::get(scalar_t val)
 {
-    out << val_;
+    atom_key_t key = {sym_atomic::Const, val, nullptr, nullptr};
+    return atom_arena_t::current().intern<atomic_const>(key, val);
 }
 
-bool atomic_const::operator==(sym_atomic const & rhs) const
+atomic_const::atomic_const(scalar_t val)
+    : sym_atomic(Const)
+    , val_(val)
 {
-    if (auto c = dynamic_cast<atomic_const const *>(&rhs))
-        return c->val_ == val_;
+}
 
-    return false;
+void atomic_const::print(llvm::raw_ostream & out) const
+{
+    out << val_;
 }
 
 scalar_t atomic_const::value() const
@@ -31,8 +47,15 @@ scalar_t atomic_const::value() const
     return val_;
 }
 
+atomic_var const * atomic_var::get(var_id var)
+{
+    atom_key_t key = {sym_atomic::Var, 0, var, nullptr};
+    return atom_arena_t::current().intern<atomic_var>(key, var);
+}
+
 atomic_var::atomic_var(var_id var)
-    : var_(var)
+    : sym_atomic(Var)
+    , var_(var)
 {
 }
 
@@ -47,21 +70,20 @@ void atomic_var::print(llvm::raw_ostream & out) const
     var_->print(out);
 }
 
-bool atomic_var::operator==(sym_atomic const & rhs) const
+var_id atomic_var::var() const
 {
-    if (auto var = dynamic_cast<atomic_var const *>(&rhs))
-        return var->var_ == var_;
-
-    return false;
+    return var_;
 }
 
-var_id atomic_var::var() const
+atomic_linear const * atomic_linear::get(sym_atomic_ptr atom, scalar_t k)
 {
-    return var_;
+    atom_key_t key = {sym_atomic::Linear, k, atom, nullptr};
+    return atom_arena_t::current().intern<atomic_linear>(key, atom, k);
 }
 
-atomic_linear::atomic_linear(sym_atomic_ptr const & atom, scalar_t k)
-    : atom_(atom)
+atomic_linear::atomic_linear(sym_atomic_ptr atom, scalar_t k)
+    : sym_atomic(Linear, atom->size() + 1, atom->depth() + 1)
+    , atom_(atom)
     , coeff_(k)
 {
 }
@@ -71,16 +93,7 @@ void atomic_linear::print(llvm::raw_ostream & out) const
     out << coeff_ << " * " << *atom_;
 }
 
-bool atomic_linear::operator==(sym_atomic const & rhs) const
-{
-    if (auto lin = dynamic_cast<atomic_linear const *>(&rhs))
-        return coeff_ == lin->coeff_
-                && *atom_ == *lin->atom_;
-
-    return false;
-}
-
-sym_atomic_ptr const & atomic_linear::atom() const
+sym_atomic_ptr atomic_linear::atom() const
 {
     return atom_;
 }
@@ -90,9 +103,18 @@ scalar_t atomic_linear::coeff() const
     return coeff_;
 }
 
-atomic_bin_op::atomic_bin_op(sym_atomic_ptr const & lhs, sym_atomic_ptr const & rhs,
+atomic_bin_op const * atomic_bin_op::get(sym_atomic_ptr lhs, sym_atomic_ptr rhs,
+                                         atomic_bin_op::op_t operation)
+{
+    atom_key_t key = {sym_atomic::BinOp, operation, lhs, rhs};
+    return atom_arena_t::current().intern<atomic_bin_op>(key, lhs, rhs, operation);
+}
+
+atomic_bin_op::atomic_bin_op(sym_atomic_ptr lhs, sym_atomic_ptr rhs,
                              atomic_bin_op::op_t operation)
-    : lhs_(lhs)
+    : sym_atomic(BinOp, lhs->size() + rhs->size() + 1,
+                 std::max(lhs->depth(), rhs->depth()) + 1)
+    , lhs_(lhs)
     , rhs_(rhs)
     , operation_(operation)
 {
@@ -111,24 +133,66 @@ void atomic_bin_op::print(llvm::raw_ostream & out) const
     out << *rhs_;
 }
 
-bool atomic_bin_op::operator==(sym_atomic const & rhs) const
+sym_atomic_ptr atomic_bin_op::lhs() const
 {
-    if (auto bin_op = dynamic_cast<atomic_bin_op const *>(&rhs))
-        return operation_ == bin_op->operation_
-                && *lhs_ == *bin_op->lhs_
-                && *rhs_ == *bin_op->rhs_;
+    return lhs_;
+}
 
-    return false;
+sym_atomic_ptr atomic_bin_op::rhs() const
+{
+    return rhs_;
+}
 
+atomic_sum const * atomic_sum::get(sym_atomic_ptr atom, scalar_t coeff, atomic_sum const * next)
+{
+    atom_key_t key = {sym_atomic::Sum, coeff, atom, next};
+    return atom_arena_t::current().intern<atomic_sum>(key, atom, coeff, next);
 }
 
-sym_atomic_ptr const & atomic_bin_op::lhs() const
+// Terms of a sum are its children, so the list doesn't add to the depth.
+atomic_sum::atomic_sum(sym_atomic_ptr atom, scalar_t coeff, atomic_sum const * next)
+    : sym_atomic(Sum, atom->size() + (next ? next->size() : 0) + 1,
+                 std::max(atom->depth() + 1, next ? next->depth() : 0u))
+    , atom_(atom)
+    , coeff_(coeff)
+    , next_(next)
 {
-    return lhs_;
 }
 
-sym_atomic_ptr const & atomic_bin_op::rhs() const
+void atomic_sum::print(llvm::raw_ostream & out) const
 {
-    return rhs_;
+    print(out, 1);
 }
 
+void atomic_sum::print(llvm::raw_ostream & out, scalar_t scale) const
+{
+    std::vector<std::string> terms;
+    for (atomic_sum const * sum = this; sum; sum = sum->next_)
+    {
+        terms.emplace_back();
+        llvm::raw_string_ostream term_out(terms.back());
+        scalar_t k = scale * sum->coeff_;
+        if (k != 1)
+            term_out << k << " * ";
+        term_out << *sum->atom_;
+    }
+
+    std::sort(terms.begin(), terms.end());
+    for (size_t i = 0; i != terms.size(); ++i)
+        out << (i ? " + " : "") << terms[i];
+}
+
+sym_atomic_ptr atomic_sum::atom() const
+{
+    return atom_;
+}
+
+scalar_t atomic_sum::coeff() const
+{
+    return coeff_;
+}
+
+atomic_sum const * atomic_sum::next() const
+{
+    return next_;
+}
@@ -1,58 +1,106 @@
 #pragma once
 
-#include <memory>
-
 #include <llvm/ADT/APInt.h>
+#include <llvm/Support/Casting.h>
 
 #include "common.h"
 
+struct atom_arena_t;
+
+// Atoms are immutable and hash-consed in 'atom_arena_t', so structurally
+// equal atoms are the same object and are compared by address.
+// They are created by 'get' functions and live until the current arena is
+// destroyed.
+//
+// Concrete type of an atom is given by its kind, so it can be inspected with
+// 'llvm::isa'/'llvm::dyn_cast' or a switch over 'kind()' without RTTI.
 struct sym_atomic
 {
-    virtual void print(llvm::raw_ostream &) const = 0;
-    virtual bool operator==(sym_atomic const &) const = 0;
+    enum kind_t {
+        Const,
+        Var,
+        Linear,
+        BinOp,
+        Sum,
+    };
+
+    kind_t kind() const { return kind_; }
+    // Number of nodes and height of the tree of the atom.
+    unsigned size() const { return size_; }
+    unsigned depth() const { return depth_; }
+
+    void print(llvm::raw_ostream &) const;
+
+    bool operator==(sym_atomic const & rhs) const { return this == &rhs; }
+    bool operator!=(sym_atomic const & rhs) const { return this != &rhs; }
+
+protected:
+    explicit sym_atomic(kind_t kind, unsigned size = 1, unsigned depth = 1)
+        : kind_(kind)
+        , size_(size)
+        , depth_(depth)
+    {
+    }
+
+private:
+    kind_t kind_;
+    unsigned size_;
+    unsigned depth_;
 };
 
-using sym_atomic_ptr = std::shared_ptr<sym_atomic>;
+using sym_atomic_ptr = sym_atomic const *;
 
 llvm::raw_ostream & operator<<(llvm::raw_ostream &, sym_atomic const &);
 
 struct atomic_const : sym_atomic
 {
-    atomic_const(scalar_t);
+    static atomic_const const * get(scalar_t);
 
-    virtual void print(llvm::raw_ostream &) const override;
-    virtual bool operator==(sym_atomic const &) const override;
+    void print(llvm::raw_ostream &) const;
+
+    static bool classof(sym_atomic const * atom) { return atom->kind() == Const; }
 
     scalar_t value() const;
 
 private:
+    friend struct atom_arena_t;
+    atomic_const(scalar_t);
+
     scalar_t val_;
 };
 
 struct atomic_var : sym_atomic
 {
-    atomic_var(var_id);
+    static atomic_var const * get(var_id);
 
-    virtual void print(llvm::raw_ostream &) const override;
-    virtual bool operator==(sym_atomic const &) const override;
+    void print(llvm::raw_ostream &) const;
+
+    static bool classof(sym_atomic const * atom) { return atom->kind() == Var; }
 
     var_id var() const;
 
 private:
+    friend struct atom_arena_t;
+    atomic_var(var_id);
+
     var_id var_;
 };
 
 struct atomic_linear : sym_atomic
 {
-    atomic_linear(sym_atomic_ptr const &, scalar_t);
+    static atomic_linear const * get(sym_atomic_ptr, scalar_t);
+
+    void print(llvm::raw_ostream &) const;
 
-    virtual void print(llvm::raw_ostream &) const override;
-    virtual bool operator==(sym_atomic const &) const override;
+    static bool classof(sym_atomic const * atom) { return atom->kind() == Linear; }
 
-    sym_atomic_ptr const & atom() const;
+    sym_atomic_ptr atom() const;
     scalar_t coeff() const;
 
 private:
+    friend struct atom_arena_t;
+    atomic_linear(sym_atomic_ptr, scalar_t);
+
     sym_atomic_ptr atom_;
     scalar_t coeff_;
 };
@@ -66,16 +114,49 @@ struct atomic_bin_op : sym_atomic
         Div,
     };
 
-    atomic_bin_op(sym_atomic_ptr const & lhs, sym_atomic_ptr const & rhs, op_t);
+    static atomic_bin_op const * get(sym_atomic_ptr lhs, sym_atomic_ptr rhs, op_t);
+
+    void print(llvm::raw_ostream &) const;
 
-    virtual void print(llvm::raw_ostream &) const override;
-    virtual bool operator==(sym_atomic const &) const override;
+    static bool classof(sym_atomic const * atom) { return atom->kind() == BinOp; }
 
-    sym_atomic_ptr const & lhs() const;
-    sym_atomic_ptr const & rhs() const;
+    sym_atomic_ptr lhs() const;
+    sym_atomic_ptr rhs() const;
 
 private:
+    friend struct atom_arena_t;
+    atomic_bin_op(sym_atomic_ptr lhs, sym_atomic_ptr rhs, op_t);
+
     sym_atomic_ptr lhs_, rhs_;
     op_t operation_;
 };
 
+// Linear combination of atoms `k1 * a1 + k2 * a2 + ...` stored as a list of
+// terms sorted by address of the atom, so every combination has exactly one
+// representation. Terms are never sums themselves. There are at least two
+// terms, their coefficients are coprime and the first one is positive; common
+// factor is kept by 'sym_expr'.
+struct atomic_sum : sym_atomic
+{
+    static atomic_sum const * get(sym_atomic_ptr atom, scalar_t coeff, atomic_sum const * next);
+
+    void print(llvm::raw_ostream &) const;
+    // Prints the sum multiplied by 'scale'. Terms are ordered by their text,
+    // so output doesn't depend on addresses.
+    void print(llvm::raw_ostream &, scalar_t scale) const;
+
+    static bool classof(sym_atomic const * atom) { return atom->kind() == Sum; }
+
+    // The first term and the rest of them.
+    sym_atomic_ptr atom() const;
+    scalar_t coeff() const;
+    atomic_sum const * next() const;
+
+private:
+    friend struct atom_arena_t;
+    atomic_sum(sym_atomic_ptr atom, scalar_t coeff, atomic_sum const * next);
+
+    sym_atomic_ptr atom_;
+    scalar_t coeff_;
+    atomic_sum const * next_;
+};
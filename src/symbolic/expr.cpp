@@ -1,22 +1,104 @@
+#include <cstdlib>
+#include <functional>
+#include <tuple>
+#include <utility>
+
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Support/MathExtras.h>
 #include <llvm/Support/raw_ostream.h>
 
+#include "arena.h"
 #include "expr.h"
 
-namespace bl = boost::logic;
+namespace
+{
+
+using term_t = std::pair<sym_atomic_ptr, scalar_t>;
+using terms_t = llvm::SmallVector<term_t, 4>;
+
+// Terms of `coeff * atom` sorted like in 'atomic_sum'.
+void collect_terms(scalar_t coeff, sym_atomic_ptr atom, terms_t & terms)
+{
+    if (auto sum = llvm::dyn_cast<atomic_sum>(atom))
+    {
+        for (; sum; sum = sum->next())
+            terms.push_back({sum->atom(), coeff * sum->coeff()});
+    }
+    else
+    {
+        terms.push_back({atom, coeff});
+    }
+}
+
+// Sum of two sorted lists of terms. Terms with zero coefficients are dropped.
+terms_t merge_terms(terms_t const & a, terms_t const & b)
+{
+    std::less<sym_atomic_ptr> less;
+    terms_t res;
+    auto i = a.begin(), j = b.begin();
+    while (i != a.end() || j != b.end())
+    {
+        term_t t;
+        if (j == b.end() || (i != a.end() && less(i->first, j->first)))
+            t = *i++;
+        else if (i == a.end() || less(j->first, i->first))
+            t = *j++;
+        else
+        {
+            t = {i->first, i->second + j->second};
+            ++i;
+            ++j;
+        }
+
+        if (t.second)
+            res.push_back(t);
+    }
+
+    return res;
+}
+
+// Common factor and atom of the linear combination, see 'atomic_sum'.
+std::pair<scalar_t, sym_atomic_ptr> make_linear(terms_t const & terms)
+{
+    if (terms.empty())
+        return {0, nullptr};
+
+    if (terms.size() == 1)
+        return {terms.front().second, terms.front().first};
+
+    scalar_t factor = 0;
+    for (term_t const & t : terms)
+        factor = llvm::GreatestCommonDivisor64(factor, std::abs(t.second));
+    if (terms.front().second < 0)
+        factor = -factor;
+
+    atomic_sum const * sum = nullptr;
+    for (auto it = terms.rbegin(); it != terms.rend(); ++it)
+        sum = atomic_sum::get(it->first, it->second / factor, sum);
+
+    return {factor, sum};
+}
+
+}
 
 sym_expr::sym_expr(scalar_t scalar)
     : coeff_(0)
     , atom_(nullptr)
     , delta_(scalar)
-    , is_special_(boost::logic::indeterminate)
 {
 }
 
-sym_expr::sym_expr(sym_atomic_ptr const & atom)
+sym_expr::sym_expr(sym_atomic_ptr atom)
     : coeff_(1)
     , atom_(atom)
     , delta_(0)
-    , is_special_(boost::logic::indeterminate)
+{
+}
+
+sym_expr::sym_expr(scalar_t coeff, sym_atomic_ptr atom, scalar_t delta)
+    : coeff_(coeff)
+    , atom_(atom)
+    , delta_(delta)
 {
 }
 
@@ -27,21 +109,17 @@ sym_expr sym_expr::operator-() const
     else if (is_bot())
         return sym_expr::top;
 
-    sym_expr res(-delta_);
-    res.atom_ = atom_;
-    res.coeff_ = -coeff_;
-    return res;
+    return sym_expr(-coeff_, atom_, -delta_);
 }
 
 sym_expr & sym_expr::operator+=(sym_expr const & rhs)
 {
-    if (!bl::indeterminate(is_special_))
+    if (is_special())
         return *this;
 
-    if (!bl::indeterminate(rhs.is_special_))
+    if (rhs.is_special())
     {
-        is_special_ = rhs.is_special_;
-        atom_.reset();
+        *this = rhs;
         return *this;
     }
 
@@ -54,21 +132,18 @@ sym_expr & sym_expr::operator+=(sym_expr const & rhs)
         coeff_ = rhs.coeff_;
         atom_ = rhs.atom_;
     }
-    else if (coeff_ == -rhs.coeff_)
-    {
-        coeff_ = 0;
-        atom_.reset();
-    }
-    else if (*atom_ == *rhs.atom_)
+    else if (atom_ == rhs.atom_)
     {
         coeff_ += rhs.coeff_;
+        if (!coeff_)
+            atom_ = nullptr;
     }
     else
     {
-        sym_atomic_ptr plus_lhs = to_atom_no_delta();
-        sym_atomic_ptr plus_rhs = rhs.to_atom_no_delta();
-        coeff_ = 1;
-        atom_ = std::make_shared<atomic_bin_op>(plus_lhs, plus_rhs, atomic_bin_op::Plus);
+        terms_t lhs_terms, rhs_terms;
+        collect_terms(coeff_, atom_, lhs_terms);
+        collect_terms(rhs.coeff_, rhs.atom_, rhs_terms);
+        std::tie(coeff_, atom_) = make_linear(merge_terms(lhs_terms, rhs_terms));
     }
 
     return *this;
@@ -82,7 +157,7 @@ sym_expr & sym_expr::operator-=(sym_expr const & rhs)
 sym_expr & sym_expr::operator*=(sym_expr const & rhs)
 {
     // bad case so nothing smart
-    if (!bl::indeterminate(rhs.is_special_) || !bl::indeterminate(is_special_))
+    if (rhs.is_special() || is_special())
         return *this;
 
     // suppose we are computing `(ax + b) * (cy + d)`
@@ -105,19 +180,19 @@ sym_expr & sym_expr::operator*=(sym_expr const & rhs)
         if (coeff_)
             atom_ = rhs.atom_;
         else
-            atom_.reset();;
+            atom_ = nullptr;
     }
     else if (c == 0)
     {
         // in this case result should be `adx + bd`
         coeff_ *= d;
         if (!coeff_)
-            atom_.reset();
+            atom_ = nullptr;
     }
     else
     {
-        sym_atomic_ptr x(std::move(atom_));
-        atom_ = std::make_shared<atomic_bin_op>(x, rhs.atom_,  atomic_bin_op::Mult);
+        sym_atomic_ptr x = atom_;
+        atom_ = atomic_bin_op::get(x, rhs.atom_, atomic_bin_op::Mult);
         coeff_ *= c;
         // at this point value is `acxy + bd`
         // we also know that `a ≠ 0` and `c ≠ 0`
@@ -143,7 +218,7 @@ sym_expr & sym_expr::operator*=(sym_expr const & rhs)
 sym_expr & sym_expr::operator/=(sym_expr const & rhs)
 {
     // bad case so nothing smart
-    if (!bl::indeterminate(rhs.is_special_) || !bl::indeterminate(is_special_))
+    if (rhs.is_special() || is_special())
         return *this;
 
     // suppose we are computing `(ax + b) * (cy + d)`
@@ -156,13 +231,16 @@ sym_expr & sym_expr::operator/=(sym_expr const & rhs)
     {
         coeff_ /= d;  // caller is responsible for `rhs ≠ 0`
         delta_ /= d;
+        if (!coeff_)
+            atom_ = nullptr;
     }
     else
     {
         // value should be `(ax + b) / (cy + d) + 0`
+        sym_atomic_ptr numerator = to_atom();
         delta_ = 0;
         coeff_ = 1;
-        atom_ = std::make_shared<atomic_bin_op>(to_atom(), rhs.to_atom(), atomic_bin_op::Div);
+        atom_ = atomic_bin_op::get(numerator, rhs.to_atom(), atomic_bin_op::Div);
     }
 
     return *this;
@@ -170,14 +248,18 @@ sym_expr & sym_expr::operator/=(sym_expr const & rhs)
 
 bool sym_expr::operator<=(sym_expr const & rhs) const
 {
+    if (is_scalar() && rhs.is_scalar())
+        return delta_ <= rhs.delta_;
+
     if (is_bot() || rhs.is_top())
         return true;
 
     if (is_top() || rhs.is_bot())
         return false;
 
-    sym_expr diff = *this - rhs;
-    if (diff.coeff_ == 0 && delta_ <= rhs.delta_)
+    // linear parts are in canonical form, so their difference is zero iff
+    // they are the same
+    if (coeff_ == rhs.coeff_ && atom_ == rhs.atom_ && delta_ <= rhs.delta_)
         return true;
 
     return false;
@@ -188,7 +270,7 @@ bool sym_expr::operator==(sym_expr const & rhs) const
     if (is_bot()) return rhs.is_bot();
     if (is_top()) return rhs.is_top();
 
-    if (!bl::indeterminate(rhs.is_special_))
+    if (rhs.is_special())
         return false;
 
     if (delta_ != rhs.delta_ || coeff_ != rhs.coeff_)
@@ -198,7 +280,7 @@ bool sym_expr::operator==(sym_expr const & rhs) const
     if (!!atom_ ^ !!rhs.atom_)
         return false;
 
-    return *atom_ == *rhs.atom_;
+    return atom_ == rhs.atom_;
 }
 
 bool sym_expr::operator!=(sym_expr const & rhs) const
@@ -206,16 +288,6 @@ bool sym_expr::operator!=(sym_expr const & rhs) const
     return !(*this == rhs);
 }
 
-bool sym_expr::is_top() const
-{
-    return is_special_ == true;
-}
-
-bool sym_expr::is_bot() const
-{
-    return is_special_ == false;
-}
-
 void sym_expr::print(llvm::raw_ostream & out) const
 {
     if (is_bot())
@@ -223,7 +295,13 @@ void sym_expr::print(llvm::raw_ostream & out) const
     else if (is_top())
         out << "top";
     else {
-        if (coeff_)
+        if (auto sum = llvm::dyn_cast_or_null<atomic_sum>(atom_))
+        {
+            sum->print(out, coeff_);
+            if (delta_)
+                out << " + ";
+        }
+        else if (coeff_)
         {
             if (coeff_ != 1)
                 out << coeff_ << " * ";
@@ -240,75 +318,66 @@ void sym_expr::print(llvm::raw_ostream & out) const
 
 boost::optional<scalar_t> sym_expr::to_scalar() const
 {
-    if (!coeff_)
+    if (is_scalar())
         return delta_;
 
     return boost::none;
 }
 
+bool sym_expr::exceeds_limits() const
+{
+    return atom_ && atom_arena_t::current().exceeds_limits(*atom_);
+}
+
 sym_atomic_ptr sym_expr::to_atom_no_delta() const
 {
-    return coeff_ == 1 ? atom_ : std::make_shared<atomic_linear>(atom_, coeff_);
+    return coeff_ == 1 ? atom_ : atomic_linear::get(atom_, coeff_);
 }
 
 sym_atomic_ptr sym_expr::to_atom() const
 {
-    if (coeff_ == 0 && delta_ == 0)
-        return std::make_shared<atomic_const>(scalar_t(0));
+    // special expressions have no atom and are converted like zero
+    if (is_special() || (coeff_ == 0 && delta_ == 0))
+        return atomic_const::get(scalar_t(0));
+
+    sym_atomic_ptr delta_atom = atomic_const::get(delta_);
+    if (coeff_ == 0)
+        return delta_atom;
 
     sym_atomic_ptr no_delta_atom = to_atom_no_delta();
     if (delta_ == 0)
         return no_delta_atom;
 
-    auto delta_atom = std::make_shared<atomic_const>(delta_);
-    if (coeff_ == 0)
-    {
-        return delta_atom;
-    }
-    else
-    {
-        return std::make_shared<atomic_bin_op>(no_delta_atom,
-                                               delta_atom,
-                                               atomic_bin_op::Plus);
-    }
-}
-
-sym_expr::sym_expr(bool is_special)
-    : coeff_(0)
-    , delta_(0)
-    , is_special_(is_special)
-{
+    return atomic_bin_op::get(no_delta_atom,
+                              delta_atom,
+                              atomic_bin_op::Plus);
 }
 
-sym_expr sym_expr::top = sym_expr(true);
-sym_expr sym_expr::bot = sym_expr(false);
+sym_expr sym_expr::top = sym_expr(1, nullptr, 0);
+sym_expr sym_expr::bot = sym_expr(-1, nullptr, 0);
 
-sym_expr operator+(sym_expr const & a, sym_expr const & b)
+sym_expr operator+(sym_expr a, sym_expr const & b)
 {
-    sym_expr res(a);
-    res += b;
-    return res;
+    a += b;
+    return a;
 }
 
-sym_expr operator-(sym_expr const & a, sym_expr const & b)
+sym_expr operator-(sym_expr a, sym_expr const & b)
 {
-    sym_expr res(a);
-    res -= b;
-    return res;
+    a -= b;
+    return a;
 }
 
-sym_expr operator*(sym_expr const & a, sym_expr const & b)
+sym_expr operator*(sym_expr a, sym_expr const & b)
 {
-    sym_expr res(a);
-    res *= b;
-    return res;
+    a *= b;
+    return a;
 }
 
-sym_expr operator/(sym_expr const & a, sym_expr const & b)
+sym_expr operator/(sym_expr a, sym_expr const & b)
 {
-    sym_expr res(a);
-    res /= b;
-    return res;
+    a /= b;
+    return a;
 }
 
 sym_expr meet(sym_expr const & a, sym_expr const & b)
@@ -339,6 +408,6 @@ llvm::raw_ostream & operator<<(llvm::raw_ostream & out, sym_expr const & e)
 
 sym_expr var_sym_expr(var_id const & v)
 {
-    return sym_expr(std::make_shared<atomic_var>(v));
+    return sym_expr(atomic_var::get(v));
 }
 
@@ -10,7 +10,7 @@ using boost::logic::tribool;
 struct sym_expr
 {
     explicit sym_expr(scalar_t);
-    explicit sym_expr(sym_atomic_ptr const &);
+    explicit sym_expr(sym_atomic_ptr);
 
     sym_expr operator-() const;
     sym_expr & operator+=(sym_expr const &);
@@ -25,8 +25,11 @@ struct sym_expr
     static sym_expr top;
     static sym_expr bot;
 
-    bool is_top() const;
-    bool is_bot() const;
+    bool is_top() const { return !atom_ && coeff_ > 0; }
+    bool is_bot() const { return !atom_ && coeff_ < 0; }
+    bool is_special() const { return !atom_ && coeff_; }
+    // Whether the expression is an integer, not special and without atoms.
+    bool is_scalar() const { return !atom_ && !coeff_; }
 
     void print(llvm::raw_ostream &) const;
 
@@ -34,22 +37,29 @@ struct sym_expr
 
     sym_atomic_ptr to_atom() const;
 
+    // Whether the atom is bigger than limits of the current arena allow.
+    bool exceeds_limits() const;
+
 private:
     sym_atomic_ptr to_atom_no_delta() const;
 private:
-    // actual value is `coeff_ * atom_ + b` unless it's a special expression
+    // Actual value is `coeff_ * atom_ + delta_`. Coefficient is zero iff there
+    // is no atom, so special expressions are encoded as a nonzero coefficient
+    // without an atom: positive for top, negative for bot.
+    // Sums of atoms are kept as 'atomic_sum' with the common factor in
+    // 'coeff_', so equal linear parts have equal 'coeff_' and 'atom_'.
     scalar_t coeff_;
     sym_atomic_ptr atom_;
     scalar_t delta_;
 
-    sym_expr(bool);
-    tribool is_special_;  // true for top, false for bot, indeterminate for usual value
+    sym_expr(scalar_t coeff, sym_atomic_ptr atom, scalar_t delta);
 };
 
-sym_expr operator+(sym_expr const & a, sym_expr const & b);
-sym_expr operator-(sym_expr const & a, sym_expr const & b);
-sym_expr operator*(sym_expr const & a, sym_expr const & b);
-sym_expr operator/(sym_expr const & a, sym_expr const & b);
+// Left operands are taken by value, so temporaries are updated in place.
+sym_expr operator+(sym_expr a, sym_expr const & b);
+sym_expr operator-(sym_expr a, sym_expr const & b);
+sym_expr operator*(sym_expr a, sym_expr const & b);
+sym_expr operator/(sym_expr a, sym_expr const & b);
 
 sym_expr meet(sym_expr const & a, sym_expr const & b);
 sym_expr join(sym_expr const & a, sym_expr const & b);
@@ -1,10 +1,147 @@
+#include "arena.h"
 #include "expr.h"
 #include "range.h"
 
+#include <algorithm>
+#include <limits>
+#include <utility>
+
 #include <llvm/Support/raw_ostream.h>
 
+namespace
+{
+
+// Most ranges are integer intervals, so operations on them don't go through
+// 'sym_expr'. Arithmetic on integer bounds is overflow-checked: a bound which
+// overflows towards infinity becomes infinite, other overflows saturate.
+
+// Integer bound. 'overflow' is -1 or 1 if the exact value is below or above
+// the range of 'scalar_t'.
+struct checked_t
+{
+    scalar_t value;
+    int overflow;
+
+    bool operator<(checked_t const & rhs) const
+    {
+        return overflow != rhs.overflow ? overflow < rhs.overflow : value < rhs.value;
+    }
+};
+
+checked_t checked_add(scalar_t a, scalar_t b)
+{
+    scalar_t res;
+    if (__builtin_add_overflow(a, b, &res))
+        return {0, b < 0 ? -1 : 1};
+
+    return {res, 0};
+}
+
+checked_t checked_sub(scalar_t a, scalar_t b)
+{
+    scalar_t res;
+    if (__builtin_sub_overflow(a, b, &res))
+        return {0, b < 0 ? 1 : -1};
+
+    return {res, 0};
+}
+
+checked_t checked_mul(scalar_t a, scalar_t b)
+{
+    scalar_t res;
+    if (__builtin_mul_overflow(a, b, &res))
+        return {0, (a < 0) != (b < 0) ? -1 : 1};
+
+    return {res, 0};
+}
+
+// 'b' must not be 0.
+checked_t checked_div(scalar_t a, scalar_t b)
+{
+    if (a == std::numeric_limits<scalar_t>::min() && b == -1)
+        return {0, 1};
+
+    return {a / b, 0};
+}
+
+sym_expr lower_bound(checked_t c)
+{
+    if (c.overflow < 0)
+        return sym_expr::bot;
+    if (c.overflow > 0)
+        return sym_expr(std::numeric_limits<scalar_t>::max());
+
+    return sym_expr(c.value);
+}
+
+sym_expr upper_bound(checked_t c)
+{
+    if (c.overflow > 0)
+        return sym_expr::top;
+    if (c.overflow < 0)
+        return sym_expr(std::numeric_limits<scalar_t>::min());
+
+    return sym_expr(c.value);
+}
+
+// Bounds with atoms over the limits of the current arena are dropped to
+// infinity, so that expressions can't grow across iterations.
+sym_expr capped_lower(sym_expr const & e)
+{
+    if (!e.exceeds_limits())
+        return e;
+
+    atom_arena_t::current().count_capped();
+    return sym_expr::bot;
+}
+
+sym_expr capped_upper(sym_expr const & e)
+{
+    if (!e.exceeds_limits())
+        return e;
+
+    atom_arena_t::current().count_capped();
+    return sym_expr::top;
+}
+
+// Integer interval, if both bounds of the range are integers.
+struct scalar_interval_t
+{
+    scalar_t lo;
+    scalar_t hi;
+};
+
+boost::optional<scalar_interval_t> to_interval(sym_range const & r)
+{
+    if (!r.lo.is_scalar() || !r.hi.is_scalar())
+        return boost::none;
+
+    return scalar_interval_t{*r.lo.to_scalar(), *r.hi.to_scalar()};
+}
+
+// Range {op(lo, e), op(hi, e)} with bounds ordered.
+template <class Op>
+sym_range scale(scalar_interval_t a, scalar_t e, Op op)
+{
+    checked_t x = op(a.lo, e), y = op(a.hi, e);
+    if (y < x)
+        std::swap(x, y);
+
+    return {lower_bound(x), upper_bound(y)};
+}
+
+}
+
 sym_range & sym_range::operator|=(sym_range const & rhs)
 {
+    auto a = to_interval(*this), b = to_interval(rhs);
+    if (a && b)
+    {
+        lo = sym_expr(std::min(a->lo, b->lo));
+        hi = sym_expr(std::max(a->hi, b->hi));
+        return *this;
+    }
+
     lo = meet(lo, rhs.lo);
     hi = join(hi, rhs.hi);
     return *this;
@@ -12,31 +149,64 @@ sym_range & sym_range::operator|=(sym_range const & rhs)
 
 sym_range & sym_range::operator&=(sym_range const & rhs)
 {
-    lo = join(lo, rhs.lo);
-    hi = meet(hi, rhs.hi);
+    auto a = to_interval(*this), b = to_interval(rhs);
+    if (a && b)
+    {
+        lo = sym_expr(std::max(a->lo, b->lo));
+        hi = sym_expr(std::min(a->hi, b->hi));
+        return *this;
+    }
+
+    // Bounds which can't be compared are both valid for the intersection.
+    // A constant one is kept, as it's what checks can use, otherwise the one
+    // of 'rhs', which usually carries the new constraint, is taken instead of
+    // dropping to an infinite bound.
+    if (!(rhs.lo <= lo) && (lo <= rhs.lo || !lo.is_scalar() || rhs.lo.is_scalar()))
+        lo = rhs.lo;
+    if (!(hi <= rhs.hi) && (rhs.hi <= hi || !hi.is_scalar() || rhs.hi.is_scalar()))
+        hi = rhs.hi;
     return *this;
 }
 
 sym_range & sym_range::operator+=(sym_range const & rhs)
 {
-    lo += rhs.lo;
-    hi += rhs.hi;
+    auto a = to_interval(*this), b = to_interval(rhs);
+    if (a && b)
+    {
+        lo = lower_bound(checked_add(a->lo, b->lo));
+        hi = upper_bound(checked_add(a->hi, b->hi));
+        return *this;
+    }
+
+    lo = capped_lower(lo + rhs.lo);
+    hi = capped_upper(hi + rhs.hi);
     return *this;
 }
 
 sym_range & sym_range::operator-=(sym_range const & rhs)
 {
-    lo -= rhs.hi;
-    hi -= rhs.lo;
+    auto a = to_interval(*this), b = to_interval(rhs);
+    if (a && b)
+    {
+        lo = lower_bound(checked_sub(a->lo, b->hi));
+        hi = upper_bound(checked_sub(a->hi, b->lo));
+        return *this;
+    }
+
+    lo = capped_lower(lo - rhs.hi);
+    hi = capped_upper(hi - rhs.lo);
     return *this;
 }
 
 sym_range & sym_range::operator*=(sym_expr const & e)
 {
-    sym_range tmp = { hi * e, lo * e };
-    lo *= e;
-    hi *= e;
-    *this |= tmp;
+    auto a = to_interval(*this);
+    if (a && e.is_scalar())
+        return *this = scale(*a, *e.to_scalar(), checked_mul);
+
+    sym_expr x = lo * e, y = hi * e;
+    lo = capped_lower(meet(x, y));
+    hi = capped_upper(join(y, x));
     return *this;
 }
 
@@ -44,16 +214,18 @@ sym_range & sym_range::operator*=(sym_range const & rhs)
 {
     sym_range tmp = *this * rhs.hi;
     *this *= rhs.lo;
-    *this |= tmp;
-    return *this;
+    return *this |= tmp;
 }
 
 sym_range & sym_range::operator/=(sym_expr const & e)
 {
-    sym_range tmp = { hi / e, lo / e };
-    lo /= e;
-    hi /= e;
-    *this |= tmp;
+    auto a = to_interval(*this);
+    if (a && e.is_scalar() && *e.to_scalar() != 0)
+        return *this = scale(*a, *e.to_scalar(), checked_div);
+
+    sym_expr x = lo / e, y = hi / e;
+    lo = capped_lower(meet(x, y));
+    hi = capped_upper(join(y, x));
     return *this;
 }
 
@@ -74,65 +246,58 @@ sym_range & sym_range::operator/=(sym_range const & rhs)
     return *this;
 }
 
-sym_range operator|(sym_range const & a, sym_range const & b)
+sym_range operator|(sym_range a, sym_range const & b)
 {
-    sym_range res = a;
-    res |= b;
-    return res;
+    a |= b;
+    return a;
 }
 
-sym_range operator&(sym_range const & a, sym_range const & b)
+sym_range operator&(sym_range a, sym_range const & b)
 {
-    sym_range res = a;
-    res &= b;
-    return res;
+    a &= b;
+    return a;
 }
 
-sym_range operator+(sym_range const & a, sym_range const & b)
+sym_range operator+(sym_range a, sym_range const & b)
 {
-    sym_range res = a;
-    res += b;
-    return res;
+    a += b;
+    return a;
 }
 
-sym_range operator-(sym_range const & a, sym_range const & b)
+sym_range operator-(sym_range a, sym_range const & b)
 {
-    sym_range res = a;
-    res -= b;
-    return res;
+    a -= b;
+    return a;
 }
 
-sym_range operator*(sym_range const & a, sym_expr const & b)
+sym_range operator*(sym_range a, sym_expr const & b)
 {
-    sym_range res = a;
-    res *= b;
-    return res;
+    a *= b;
+    return a;
 }
 
-sym_range operator*(sym_expr const & a, sym_range const & b)
+sym_range operator*(sym_expr const & a, sym_range b)
 {
-    return b * a;
+    b *= a;
+    return b;
 }
 
-sym_range operator*(sym_range const & a, sym_range const & b)
+sym_range operator*(sym_range a, sym_range const & b)
 {
-    sym_range res = a;
-    res *= b;
-    return res;
+    a *= b;
+    return a;
 }
 
-sym_range operator/(sym_range const & a, sym_expr const & b)
+sym_range operator/(sym_range a, sym_expr const & b)
 {
-    sym_range res = a;
-    res /= b;
-    return res;
+    a /= b;
+    return a;
 }
 
-sym_range operator/(sym_range const & a, sym_range const & b)
+sym_range operator/(sym_range a, sym_range const & b)
 {
-    sym_range res = a;
-    res /= b;
-    return res;
+    a /= b;
+    return a;
 }
 
 sym_range sym_range::full = { sym_expr::bot, sym_expr::top };
@@ -148,6 +313,43 @@ bool operator!=(sym_range const & a, sym_range const & b)
     return !(a == b);
 }
 
+sym_range widen(sym_range const & prev, sym_range const & next,
+                std::vector<sym_expr> const & thresholds)
+{
+    // nothing to extrapolate from
+    if (prev.lo.is_top() || prev.hi.is_bot())
+        return next;
+
+    sym_range res = prev;
+    if (!(prev.lo <= next.lo))
+    {
+        res.lo = sym_expr::bot;
+        for (sym_expr const & t : thresholds)
+        {
+            if (t <= next.lo && res.lo <= t)
+                res.lo = t;
+        }
+    }
+
+    if (!(next.hi <= prev.hi))
+    {
+        res.hi = sym_expr::top;
+        for (sym_expr const & t : thresholds)
+        {
+            if (next.hi <= t && t <= res.hi)
+                res.hi = t;
+        }
+    }
+
+    return res;
+}
+
+sym_range narrow(sym_range const & prev, sym_range const & next)
+{
+    return { prev.lo.is_bot() ? next.lo : prev.lo,
+             prev.hi.is_top() ? next.hi : prev.hi };
+}
+
 llvm::raw_ostream & operator<<(llvm::raw_ostream & out, sym_range const & r)
 {
     return out << "[" << r.lo << "; " << r.hi << "]";
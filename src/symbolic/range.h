@@ -1,5 +1,7 @@
 #include "expr.h"
 
+#include <vector>
+
 #include <boost/optional.hpp>
 
 #include <llvm/Support/raw_ostream.h>
@@ -23,20 +25,28 @@ struct sym_range
     static sym_range empty;
 };
 
-sym_range operator|(sym_range const & a, sym_range const & b);
-sym_range operator&(sym_range const & a, sym_range const & b);
+// Left ranges are taken by value, so temporaries are updated in place.
+sym_range operator|(sym_range a, sym_range const & b);
+sym_range operator&(sym_range a, sym_range const & b);
 
-sym_range operator+(sym_range const & a, sym_range const & b);
-sym_range operator-(sym_range const & a, sym_range const & b);
-sym_range operator*(sym_range const & a, sym_expr const & b);
-sym_range operator*(sym_expr const & a, sym_range const & b);
-sym_range operator*(sym_range const & a, sym_range const & b);
-sym_range operator/(sym_range const & a, sym_expr const & b);
-sym_range operator/(sym_range const & a, sym_range const & b);
+sym_range operator+(sym_range a, sym_range const & b);
+sym_range operator-(sym_range a, sym_range const & b);
+sym_range operator*(sym_range a, sym_expr const & b);
+sym_range operator*(sym_expr const & a, sym_range b);
+sym_range operator*(sym_range a, sym_range const & b);
+sym_range operator/(sym_range a, sym_expr const & b);
+sym_range operator/(sym_range a, sym_range const & b);
 
 bool operator==(sym_range const & a, sym_range const & b);
 bool operator!=(sym_range const & a, sym_range const & b);
 
+// Widening: bounds of 'next' which went beyond bounds of 'prev' are moved to
+// the nearest threshold, or to infinity if there is no comparable one.
+sym_range widen(sym_range const & prev, sym_range const & next,
+                std::vector<sym_expr> const & thresholds);
+// Narrowing: infinite bounds of 'prev' are replaced with bounds of 'next'.
+sym_range narrow(sym_range const & prev, sym_range const & next);
+
 llvm::raw_ostream & operator<<(llvm::raw_ostream &, sym_range const &);
 
 sym_range const_sym_range(scalar_t);